@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include "devices/ide.h"
 #include "threads/malloc.h"
+#include "threads/trace.h"
 
 /* A block device. */
 struct block
@@ -121,10 +122,38 @@ void
 block_read (struct block *block, block_sector_t sector, void *buffer)
 {
   check_sector (block, sector);
+  trace (TRACE_BLOCK_READ, sector, block->type);
   block->ops->read (block->aux, sector, buffer);
   block->read_cnt++;
 }
 
+/* Reads CNT consecutive sectors starting at SECTOR from BLOCK
+   into BUFFER, which must have room for CNT * BLOCK_SECTOR_SIZE
+   bytes.  Devices that can transfer several sectors with one
+   command do so; others are read a sector at a time.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void
+block_read_multiple (struct block *block, block_sector_t sector,
+                     void *buffer_, block_sector_t cnt)
+{
+  uint8_t *buffer = buffer_;
+
+  if (cnt == 0)
+    return;
+  check_sector (block, sector);
+  check_sector (block, sector + cnt - 1);
+  if (block->ops->read_multiple != NULL)
+    {
+      trace (TRACE_BLOCK_READ, sector, block->type);
+      block->ops->read_multiple (block->aux, sector, buffer, cnt);
+      block->read_cnt += cnt;
+    }
+  else
+    for (; cnt > 0; cnt--, sector++, buffer += BLOCK_SECTOR_SIZE)
+      block_read (block, sector, buffer);
+}
+
 /* Write sector SECTOR to BLOCK from BUFFER, which must contain
    BLOCK_SECTOR_SIZE bytes.  Returns after the block device has
    acknowledged receiving the data.
@@ -135,6 +164,7 @@ block_write (struct block *block, block_sector_t sector, const void *buffer)
 {
   check_sector (block, sector);
   ASSERT (block->type != BLOCK_FOREIGN);
+  trace (TRACE_BLOCK_WRITE, sector, block->type);
   block->ops->write (block->aux, sector, buffer);
   block->write_cnt++;
 }
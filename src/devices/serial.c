@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <string.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -33,6 +33,13 @@
 #define MCR_REG (IO_BASE + 4)   /* MODEM Control Register. */
 #define LSR_REG (IO_BASE + 5)   /* Line Status Register (read-only). */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable the 16-byte FIFOs. */
+#define FCR_CLEAR 0x06          /* Clear both FIFOs. */
+
+/* Bytes the transmit FIFO accepts once THR reads empty. */
+#define TX_FIFO_SIZE 16
+
 /* Interrupt Enable Register bits. */
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
@@ -51,12 +58,24 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Data to be transmitted: a ring of TXQ_SIZE bytes, written by
+   serial_putbuf() and drained by the interrupt handler.  Only
+   touched with interrupts off.  Much larger than an intq, so a
+   burst of output rarely has to fall back to polling. */
+#define TXQ_SIZE 4096
+static uint8_t txq[TXQ_SIZE];
+static size_t txq_head;                 /* Next byte to transmit. */
+static size_t txq_cnt;                  /* Bytes queued. */
+
+/* Threads blocked in serial_putbuf() waiting for room in the
+   transmit queue.  Woken as the queue drains. */
+static struct list txq_waiters;
 
 static void set_serial (int bps);
+static uint8_t txq_getc (void);
 static void putc_poll (uint8_t);
 static void write_ier (void);
+static void wake_writers (void);
 static intr_handler_func serial_interrupt;
 
 /* Initializes the serial port device for polling mode.
@@ -71,7 +90,6 @@ init_poll (void)
   outb (FCR_REG, 0);                    /* Disable FIFO. */
   set_serial (9600);                    /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-  intq_init (&txq);
   mode = POLL;
 } 
 
@@ -87,7 +105,10 @@ serial_init_queue (void)
     init_poll ();
   ASSERT (mode == POLL);
 
+  list_init (&txq_waiters);
   intr_register_ext (0x20 + 4, serial_interrupt, "serial");
+  /* Let each transmit interrupt hand the UART a FIFO's worth. */
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR);
   mode = QUEUE;
   old_level = intr_disable ();
   write_ier ();
@@ -98,31 +119,66 @@ serial_init_queue (void)
 void
 serial_putc (uint8_t byte) 
 {
+  serial_putbuf (&byte, 1);
+}
+
+/* Sends the N bytes in BUFFER to the serial port, queuing them
+   all with interrupts disabled once rather than once per
+   byte.  If the queue fills up, a caller that had interrupts on
+   sleeps until the interrupt handler makes room; one that had
+   them off sends bytes by polling instead. */
+void
+serial_putbuf (const void *buffer, size_t n) 
+{
+  const uint8_t *p = buffer;
   enum intr_level old_level = intr_disable ();
 
   if (mode != QUEUE)
     {
       /* If we're not set up for interrupt-driven I/O yet,
-         use dumb polling to transmit a byte. */
+         use dumb polling to transmit. */
       if (mode == UNINIT)
         init_poll ();
-      putc_poll (byte); 
+      while (n-- > 0)
+        putc_poll (*p++); 
     }
   else 
     {
-      /* Otherwise, queue a byte and update the interrupt enable
-         register. */
-      if (old_level == INTR_OFF && intq_full (&txq)) 
+      /* Otherwise, queue the bytes and update the interrupt
+         enable register. */
+      while (n > 0)
         {
-          /* Interrupts are off and the transmit queue is full.
-             If we wanted to wait for the queue to empty,
-             we'd have to reenable interrupts.
-             That's impolite, so we'll send a character via
-             polling instead. */
-          putc_poll (intq_getc (&txq)); 
+          size_t tail = (txq_head + txq_cnt) % TXQ_SIZE;
+          size_t chunk = TXQ_SIZE - txq_cnt;
+
+          if (chunk == 0) 
+            {
+              /* The transmit queue is full. */
+              if (old_level == INTR_ON && !intr_context ())
+                {
+                  /* Wait for the interrupt handler to drain some
+                     of it. */
+                  write_ier ();
+                  list_push_back (&txq_waiters, &thread_current ()->elem);
+                  thread_block ();
+                }
+              else
+                {
+                  /* We cannot sleep, so send a byte via
+                     polling. */
+                  putc_poll (txq_getc ()); 
+                }
+              continue;
+            }
+          if (chunk > TXQ_SIZE - tail)
+            chunk = TXQ_SIZE - tail;
+          if (chunk > n)
+            chunk = n;
+          memcpy (txq + tail, p, chunk);
+          txq_cnt += chunk;
+          p += chunk;
+          n -= chunk;
         }
-
-      intq_putc (&txq, byte); 
       write_ier ();
     }
   
@@ -135,8 +191,10 @@ void
 serial_flush (void) 
 {
   enum intr_level old_level = intr_disable ();
-  while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+  while (txq_cnt > 0)
+    putc_poll (txq_getc ());
+  if (mode == QUEUE)
+    wake_writers ();
   intr_set_level (old_level);
 }
 
@@ -182,7 +240,7 @@ write_ier (void)
 
   /* Enable transmit interrupt if we have any characters to
      transmit. */
-  if (!intq_empty (&txq))
+  if (txq_cnt > 0)
     ier |= IER_XMIT;
 
   /* Enable receive interrupt if we have room to store any
@@ -205,6 +263,32 @@ putc_poll (uint8_t byte)
   outb (THR_REG, byte);
 }
 
+/* Removes and returns the oldest byte in the transmit queue,
+   which must not be empty. */
+static uint8_t
+txq_getc (void) 
+{
+  uint8_t byte;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (txq_cnt > 0);
+  byte = txq[txq_head];
+  txq_head = (txq_head + 1) % TXQ_SIZE;
+  txq_cnt--;
+  return byte;
+}
+
+/* Wakes the threads waiting for room in the transmit queue, if
+   there is any. */
+static void
+wake_writers (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  while (txq_cnt < TXQ_SIZE && !list_empty (&txq_waiters))
+    thread_unblock (list_entry (list_pop_front (&txq_waiters),
+                                struct thread, elem));
+}
+
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) 
@@ -218,10 +302,16 @@ serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* Once the transmitter is empty, refill its whole FIFO from
+     the queue. */
+  if ((inb (LSR_REG) & LSR_THRE) != 0) 
+    {
+      int i;
+      for (i = 0; i < TX_FIFO_SIZE && txq_cnt > 0; i++)
+        outb (THR_REG, txq_getc ());
+    }
+
+  wake_writers ();
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
@@ -0,0 +1,57 @@
+/* perfstat.c
+
+   Prints the kernel's performance counters.  Each named counter
+   is printed as "description: value", followed by the number of
+   calls made to each system call that has been used and the
+   system-wide latency histogram of each kind of event seen. */
+
+#include <perfctr.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <syscall.h>
+
+static const char *names[PERF_CNT] =
+  {
+#define PERF_NAME(NAME, DESC) DESC,
+    PERF_COUNTERS (PERF_NAME)
+#undef PERF_NAME
+  };
+
+int
+main (void) 
+{
+  unsigned long long values[PERF_TOTAL];
+  unsigned buckets[PERF_LAT_BUCKETS];
+  int cnt, i, b;
+
+  cnt = perf_read (0, PERF_TOTAL, values);
+  for (i = 0; i < cnt && i < PERF_CNT; i++)
+    printf ("%s: %llu\n", names[i], values[i]);
+  for (i = PERF_SYSCALL_BASE; i < cnt; i++)
+    if (values[i] != 0)
+      printf ("system call %d: %llu\n", i - PERF_SYSCALL_BASE, values[i]);
+
+  for (i = 0; i < PERF_LAT_TOTAL; i++)
+    {
+      bool empty = true;
+      if (!perf_hist (i, false, buckets))
+        continue;
+      for (b = 0; b < PERF_LAT_BUCKETS; b++)
+        if (buckets[b] != 0)
+          {
+            if (empty)
+              {
+                if (i < PERF_LAT_FAULT_BASE)
+                  printf ("system call %d cycles:", i - PERF_LAT_SYSCALL_BASE);
+                else
+                  printf ("%s cycles:",
+                          names[PERF_PF_ZERO + i - PERF_LAT_FAULT_BASE]);
+                empty = false;
+              }
+            printf (" [2^%d]=%u", b, buckets[b]);
+          }
+      if (!empty)
+        printf ("\n");
+    }
+  return EXIT_SUCCESS;
+}
@@ -3,48 +3,12 @@
 #include "string.h"
 #include "devices/block.h"
 #include "threads/malloc.h"
+#include "threads/perf.h"
+#include "threads/trace.h"
 
 struct _disk_cache *disk_cache;   /* The page cache object */
 uint8_t *mem_cache;         /* The memory for the cache region */
 
-void rwlock_init( struct _rw_lock *rw )
-{
-  rw->reader = 0;
-  lock_init(&rw->lock);
-  lock_init(&rw->write_lock);
-}
-
-void rwlock_acquire_read_lock (struct _rw_lock *rw)
-{
-  lock_acquire(&rw->lock);
-  rw->reader++;
-  if(rw->reader == 1)       /* First reader hold write lock */
-  {
-    lock_acquire(&rw->write_lock);
-  }
-  lock_release(&rw->lock);
-}
-
-void rwlock_release_read_lock (struct _rw_lock *rw)
-{
-  lock_acquire(&rw->lock);
-  rw->reader--;
-  if(rw->reader == 0);     /* Last reader --> allow write */
-  {
-    lock_release(&rw->write_lock);
-  }
-  lock_release(&rw->lock);
-}
-
-void rwlock_acquire_write_lock(struct _rw_lock *rw)
-{
-  lock_acquire(&rw->write_lock);
-}
-
-void rwlock_release_write_lock(struct _rw_lock *rw)
-{
-  lock_release(&rw->write_lock);
-}
 /*
     Helper function for cached read and write
 */
@@ -92,6 +56,14 @@ static void block_sector_set_valid(struct _block_sector *b, bool valid);
 static bool block_sector_is_accessed(struct _block_sector *b);
 /* Set a block sector dirty or not */
 static void block_sector_set_accessed(struct _block_sector *b, bool access);
+/* Return block sector is held by the journal or not */
+static bool block_sector_is_logged(struct _block_sector *b);
+/* Set a block sector held by the journal or not */
+static void block_sector_set_logged(struct _block_sector *b, bool logged);
+/* Return whether a block sector may be given to another sector */
+static bool block_sector_is_evictable(struct _block_sector *b);
+/* Write to a sector through the cache and mark it dirty, and logged if asked */
+static void cache_write(block_sector_t sector, void *data, uint32_t offset, uint32_t len, bool logged);
 /* Destroy the page cache */
 
 void disk_cache_init()
@@ -118,38 +90,93 @@ void disk_cache_init()
 
 void cached_read(block_sector_t sector, void *data, uint32_t offset, uint32_t len)
 {
-    // check if the block is in the cache
-    struct _block_sector *b = disk_cache_search(sector);
-    if(b == NULL)
+    struct _block_sector *b;
+    while(1)
     {
-      b = disk_cache_load(sector, false);
+      // check if the block is in the cache
+      b = disk_cache_search(sector);
+      if(b == NULL)
+      {
+        perf_inc(PERF_CACHE_MISS);
+        b = disk_cache_load(sector, false);
+      }
+      else
+        perf_inc(PERF_CACHE_HIT);
+      rwlock_acquire_read(&b->rw);
+      if(b->sector == sector) break;
+      /* Evicted between lookup and lock, look it up again */
+      rwlock_release_read(&b->rw);
     }
-    rwlock_acquire_read_lock(&b->rw);
     memcpy(data, b->data + offset, len);
     block_sector_set_accessed(b, true);
-    rwlock_release_read_lock(&b->rw);
+    rwlock_release_read(&b->rw);
 }
 
 
 void cached_write(block_sector_t sector, void *data, uint32_t offset, uint32_t len)
+{
+    cache_write(sector, data, offset, len, false);
+}
+
+/* 
+    Like cached_write(), but the sector stays in the cache and is not written
+    back until the journal has committed it and calls disk_cache_unlog()
+*/
+void cached_write_logged(block_sector_t sector, void *data, uint32_t offset, uint32_t len)
+{
+    cache_write(sector, data, offset, len, true);
+}
+
+void disk_cache_unlog(block_sector_t sector)
+{
+    struct _block_sector *b = disk_cache_search(sector);
+    if(b == NULL) return;
+    rwlock_acquire_write(&b->rw);
+    if(b->sector == sector)
+        block_sector_set_logged(b, false);
+    rwlock_release_write(&b->rw);
+}
+
+void disk_cache_flush(block_sector_t sector)
 {
     struct _block_sector *b = disk_cache_search(sector);
-    if(b == NULL)
+    /* Not in the cache means it was written back when evicted */
+    if(b == NULL) return;
+    if(b->sector == sector && block_sector_is_dirty(b) && !block_sector_is_logged(b))
+        block_sector_flush(b, false);
+}
+
+static void cache_write(block_sector_t sector, void *data, uint32_t offset, uint32_t len, bool logged)
+{
+    struct _block_sector *b;
+    while(1)
     {
-      if (offset > 0 || len < BLOCK_SECTOR_SIZE)
+      b = disk_cache_search(sector);
+      if(b == NULL)
       {
-        b = disk_cache_load(sector, false);
+        perf_inc(PERF_CACHE_MISS);
+        if (offset > 0 || len < BLOCK_SECTOR_SIZE)
+        {
+          b = disk_cache_load(sector, false);
+        }
+        else
+        {
+            b= disk_cache_load(sector, true);
+        }
       }
       else
-      {
-          b= disk_cache_load(sector, true);
-      }
+        perf_inc(PERF_CACHE_HIT);
+      rwlock_acquire_write(&b->rw);
+      if(b->sector == sector) break;
+      /* Evicted between lookup and lock, look it up again */
+      rwlock_release_write(&b->rw);
     }
-    rwlock_acquire_read_lock(&b->rw);
     memcpy(b->data + offset, data, len);
     block_sector_set_accessed(b, true);
     block_sector_set_dirty(b, true);
-    rwlock_release_read_lock(&b->rw);
+    if(logged)
+        block_sector_set_logged(b, true);
+    rwlock_release_write(&b->rw);
 }
 
 void disk_cache_flush_all()
@@ -161,7 +188,8 @@ void disk_cache_flush_all()
     while((e = list_next(e)) != list_end(&disk_cache->sector_list))
     {
         b = list_entry(e, struct _block_sector, elem);
-        if(block_sector_is_dirty(b)) 
+        /* Logged sectors must wait for their transaction to commit */
+        if(block_sector_is_dirty(b) && !block_sector_is_logged(b)) 
         {
             block_sector_flush(b, false);
         }
@@ -225,7 +253,7 @@ static struct _block_sector *disk_cache_load(block_sector_t sector, bool write)
         b = disk_cache_rotate();
         if(!block_sector_is_accessed(b))    /* If this sector is not accessed --> evict */
         {
-            if(ref_count_get(b) == 0) break;
+            if(block_sector_is_evictable(b)) break;
         }
         else
         {
@@ -239,7 +267,7 @@ static struct _block_sector *disk_cache_load(block_sector_t sector, bool write)
             {
                 if(!block_sector_is_dirty(b)) /* This sector is not dirty --> evict */
                 {
-                    if(ref_count_get(b) == 0) break;
+                    if(block_sector_is_evictable(b)) break;
                 }
                 else
                 {
@@ -247,20 +275,26 @@ static struct _block_sector *disk_cache_load(block_sector_t sector, bool write)
                     if(j > CACHE_SIZE)             /* All sectors are dirty --> just evict randomly one */
                     {
                         b = disk_cache_rotate();
-                        if(ref_count_get(b) == 0) break;
+                        if(block_sector_is_evictable(b)) break;
                     }   
                 }  
             }
         }
     }
     // DBG_MSG_FS("[FS - %s] evict sector %d for new sector %d at it %d %d\n", thread_name(), b->sector, sector, i, j);
+    if(b->sector != (block_sector_t) CACHE_MAGIC && b->sector != (block_sector_t) -1)
+    {
+        perf_inc(PERF_CACHE_EVICT);
+        trace(TRACE_CACHE_EVICT, b->sector, block_sector_is_dirty(b));
+    }
     if(block_sector_is_dirty(b))    /* If b is dirty, then write back */
     {
         // DBG_MSG_FS("[FS - %s] fflush dirty sector %d for new sector %d at it %d %d\n", thread_name(), b->sector, sector, i, j);
         block_sector_flush(b, true);
     }
-    rwlock_acquire_write_lock(&b->rw);
+    rwlock_acquire_write(&b->rw);
     memset(b->data, 0, BLOCK_SECTOR_SIZE);
+    trace(TRACE_CACHE_LOAD, sector, !write);
     if(!write)
         block_read(fs_device, sector, b->data);
     block_sector_set_accessed(b, false);
@@ -268,7 +302,7 @@ static struct _block_sector *disk_cache_load(block_sector_t sector, bool write)
     lock_acquire(&b->lock);
     b->sector = sector;
     lock_release(&b->lock);
-    rwlock_release_write_lock(&b->rw);
+    rwlock_release_write(&b->rw);
     return b;
 }
 
@@ -281,9 +315,9 @@ static void block_sector_load(struct _block_sector *b)
         thread_yield();
     }
     ref_count_incr(b);
-    rwlock_acquire_write_lock(&b->rw);
+    rwlock_acquire_write(&b->rw);
     block_read(fs_device, b->sector, b->data);
-    rwlock_release_write_lock(&b->rw);
+    rwlock_release_write(&b->rw);
     ref_count_decr(b);
 }
 
@@ -296,12 +330,13 @@ static void block_sector_flush(struct _block_sector *b, bool evict)
         thread_yield();
     }
     // ref_count_incr(b);
-    rwlock_acquire_write_lock(&b->rw);
+    rwlock_acquire_write(&b->rw);
     block_sector_set_accessed(b, false);
     block_sector_set_dirty(b, false);
+    perf_inc(PERF_CACHE_WRITEBACK);
     block_write(fs_device, b->sector, b->data);
     if(evict) b->sector = -1;
-    rwlock_release_write_lock(&b->rw);
+    rwlock_release_write(&b->rw);
     // ref_count_decr(b);
 }
 
@@ -369,4 +404,33 @@ static void block_sector_set_valid(struct _block_sector *b, bool valid)
         b->flags &= ~ (uint32_t) PC_V;
     }
     lock_release(&b->lock);
-}
\ No newline at end of file
+}
+
+static bool block_sector_is_logged(struct _block_sector *b)
+{
+    lock_acquire(&b->lock);
+    bool status = ((b->flags & PC_L) != 0);
+    lock_release(&b->lock);
+    return status;
+}
+
+static void block_sector_set_logged(struct _block_sector *b, bool logged)
+{
+    lock_acquire(&b->lock);
+    if (logged)
+    {
+        b->flags |= PC_L;
+    }
+    else
+    {
+        b->flags &= ~ (uint32_t) PC_L;
+    }
+    lock_release(&b->lock);
+}
+
+/* A logged sector must not be written back before its transaction commits,
+   so it stays in the cache until then */
+static bool block_sector_is_evictable(struct _block_sector *b)
+{
+    return ref_count_get(b) == 0 && !block_sector_is_logged(b);
+}
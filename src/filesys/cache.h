@@ -13,25 +13,7 @@
 #define PC_A        (0x1)   /* Access bit */
 #define PC_D        (0x2)   /* Dirty bit */
 #define PC_V        (0x4)   /* Valid bit */
-
-/* RW lock, use in page cache and inode */
-struct _rw_lock
-{
-  struct lock lock;           /* General lock */
-  struct lock write_lock;     /* Write lock */
-  uint32_t reader;            /* number of reader in lock */
-};
-
-void rwlock_init( struct _rw_lock *rw );
-
-void rwlock_acquire_read_lock (struct _rw_lock *rw);
-
-void rwlock_release_read_lock (struct _rw_lock *rw);
-
-void rwlock_acquire_write_lock(struct _rw_lock *rw);
-
-void rwlock_release_write_lock(struct _rw_lock *rw);
-
+#define PC_L        (0x8)   /* Logged bit: held for the journal, never written back */
 
 struct _block_sector         /* A block sector in disk cache */ 
 {
@@ -41,7 +23,7 @@ struct _block_sector         /* A block sector in disk cache */
     uint32_t flags;         /* Flags */
     uint8_t *data;          /* Data of the sector */
     struct lock lock;       /* Accessed lock */
-    struct _rw_lock rw;     /* r/w lock */
+    struct rwlock rw;       /* r/w lock */
 };
 
 struct _disk_cache           /* The buffer cache object */
@@ -58,4 +40,10 @@ void disk_cache_flush_all(void);
 void cached_read(block_sector_t sector, void *data, uint32_t offs, uint32_t len);
 /* Cached wrie, wrapper of block_write */
 void cached_write(block_sector_t sector, void *data, uint32_t offs, uint32_t len);
+/* Cached write of a sector the journal is logging, see filesys/journal.c */
+void cached_write_logged(block_sector_t sector, void *data, uint32_t offs, uint32_t len);
+/* Let a logged sector be written back again once its transaction committed */
+void disk_cache_unlog(block_sector_t sector);
+/* Write one sector back to disk if it is dirty */
+void disk_cache_flush(block_sector_t sector);
 #endif // !_CACHE_H_
@@ -4,8 +4,21 @@
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 
+static bool create_dir(const char *name);
+
+/* Object cache for directory handles. */
+static struct obj_cache *dir_cache;
+
+/* Initializes the directory module. */
+void
+dir_init (void)
+{
+  dir_cache = obj_cache_create ("dir", sizeof (struct dir));
+  ASSERT (dir_cache != NULL);
+}
 
 /* Creates a directory with space for ENTRY_CNT entries in the
    given SECTOR.  Returns true if successful, false on failure. */
@@ -30,6 +43,17 @@ root_dir_create (block_sector_t sector, size_t entry_cnt)
 */
 
 bool dir_create(const char *name)
+{
+  bool success;
+
+  journal_begin();
+  success = create_dir(name);
+  journal_end();
+  return success;
+}
+
+/* Does the work for dir_create() */
+static bool create_dir(const char *name)
 {
  char new_dir[128]; // an copy of dir
  strlcpy(new_dir, name, 128);
@@ -139,18 +163,20 @@ struct dir *open_dir(const char *name)
    it takes ownership.  Returns a null pointer on failure. */
 struct dir *dir_open (struct inode *inode) 
 {
-  struct dir *dir = calloc (1, sizeof *dir);
+  struct dir *dir = obj_cache_alloc (dir_cache);
   if (inode != NULL && dir != NULL)
     {
       ASSERT(inode->data.flags);
       dir->inode = inode;
+      dir->parent = NULL;
       dir->pos = 0;
       return dir;
     }
   else
     {
       inode_close (inode);
-      free (dir);
+      if (dir != NULL)
+        obj_cache_free (dir_cache, dir);
       return NULL; 
     }
 }
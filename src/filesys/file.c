@@ -107,6 +107,70 @@ file_write_at (struct file *file, const void *buffer, off_t size,
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads into the CNT buffers of IOV from FILE, starting at the
+   file's current position, as a single operation on the inode.
+   Returns the number of bytes actually read and advances FILE's
+   position by that much. */
+off_t
+file_readv (struct file *file, const struct iovec *iov, int cnt) 
+{
+  off_t bytes_read = file_readv_at (file, iov, cnt, file->pos);
+  file->pos += bytes_read;
+  return bytes_read;
+}
+
+/* Reads into the CNT buffers of IOV from FILE, starting at
+   offset FILE_OFS.  Returns the number of bytes actually read.
+   The file's current position is unaffected. */
+off_t
+file_readv_at (struct file *file, const struct iovec *iov, int cnt,
+               off_t file_ofs) 
+{
+  if (file_ofs >= inode_length (file->inode))
+    return 0;
+  return inode_readv_at (file->inode, iov, cnt, file_ofs);
+}
+
+/* Writes the CNT buffers of IOV into FILE, starting at the
+   file's current position, as a single operation on the inode.
+   Returns the number of bytes actually written and advances
+   FILE's position by that much. */
+off_t
+file_writev (struct file *file, const struct iovec *iov, int cnt) 
+{
+  off_t bytes_written = file_writev_at (file, iov, cnt, file->pos);
+  file->pos += bytes_written;
+  return bytes_written;
+}
+
+/* Writes the CNT buffers of IOV into FILE, starting at offset
+   FILE_OFS.  Returns the number of bytes actually written.
+   The file's current position is unaffected. */
+off_t
+file_writev_at (struct file *file, const struct iovec *iov, int cnt,
+                off_t file_ofs) 
+{
+  return inode_writev_at (file->inode, iov, cnt, file_ofs);
+}
+
+/* Copies up to SIZE bytes from SRC's current position to DST's
+   current position without passing through a user buffer.
+   Returns the number of bytes copied, which may be less than
+   SIZE if the end of SRC is reached, and advances both
+   positions by that much.  Returns -1, copying nothing, if
+   writes to DST are denied. */
+off_t
+file_copy (struct file *dst, struct file *src, off_t size) 
+{
+  off_t bytes_copied = inode_copy_range (dst->inode, dst->pos,
+                                         src->inode, src->pos, size);
+  if (bytes_copied < 0)
+    return -1;
+  src->pos += bytes_copied;
+  dst->pos += bytes_copied;
+  return bytes_copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
@@ -7,12 +7,15 @@
 #include "filesys/inode.h"
 #include "filesys/directory.h"
 #include "filesys/cache.h"
+#include "filesys/journal.h"
 #include "threads/thread.h"
 
 /* Partition that contains the file system. */
 struct block *fs_device;
 
 static void do_format (void);
+static bool create_file (const char *name, off_t initial_size, bool zero);
+static bool remove_file (const char *name);
 
 /* Initializes the file system module.
    If FORMAT is true, reformats the file system. */
@@ -24,11 +27,13 @@ filesys_init (bool format)
     PANIC ("No file system device found, can't initialize file system.");
   DBG_MSG_FS("[FS - %s] Get file system block\n", thread_name());
   inode_init ();
+  dir_init ();
   free_map_init ();
 
   if (format) 
     do_format ();
 
+  journal_init ();
   free_map_open ();
 }
 
@@ -38,6 +43,7 @@ void
 filesys_done (void) 
 {
   free_map_close ();
+  journal_done ();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
@@ -46,6 +52,32 @@ filesys_done (void)
    or if internal memory allocation fails. */
 bool
 filesys_create (const char *name, off_t initial_size) 
+{
+  bool success;
+
+  journal_begin ();
+  success = create_file (name, initial_size, true);
+  journal_end ();
+  return success;
+}
+
+/* Like filesys_create(), but the new file's data is not zeroed,
+   so the caller must write all INITIAL_SIZE bytes of it. */
+bool
+filesys_create_unzeroed (const char *name, off_t initial_size)
+{
+  bool success;
+
+  journal_begin ();
+  success = create_file (name, initial_size, false);
+  journal_end ();
+  return success;
+}
+
+/* Does the work for filesys_create(); the data is zeroed only if
+   ZERO is true */
+static bool
+create_file (const char *name, off_t initial_size, bool zero)
 {
 
  char new_file[128]; // an copy of dir
@@ -86,7 +118,9 @@ filesys_create (const char *name, off_t initial_size)
   ASSERT(workdir != NULL);
   success =       success && (workdir != NULL
                   && free_map_allocate (1, &inode_sector)
-                  && inode_create (inode_sector, initial_size, 0)
+                  && (zero
+                      ? inode_create (inode_sector, initial_size, 0)
+                      : inode_create_unzeroed (inode_sector, initial_size, 0))
                   && dir_add (workdir, hier[i], inode_sector));
   if (!success && inode_sector != 0) 
     free_map_release (inode_sector, 1);
@@ -165,6 +199,18 @@ filesys_open (const char *name)
    or if an internal memory allocation fails. */
 bool
 filesys_remove (const char *name) 
+{
+  bool success;
+
+  journal_begin ();
+  success = remove_file (name);
+  journal_end ();
+  return success;
+}
+
+/* Does the work for filesys_remove() */
+static bool
+remove_file (const char *name)
 {
  char new_file[128]; // an copy of dir
  strlcpy(new_file, name, 128);
@@ -221,6 +267,7 @@ do_format (void)
   free_map_create ();
   if (!root_dir_create (ROOT_DIR_SECTOR, 16))
     PANIC ("root directory creation failed");
+  journal_create ();
   free_map_close ();
   printf ("done.\n");
 }
@@ -4,6 +4,7 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per sector. */
@@ -17,6 +18,7 @@ free_map_init (void)
     PANIC ("bitmap creation failed--file system device is too large");
   bitmap_mark (free_map, FREE_MAP_SECTOR);
   bitmap_mark (free_map, ROOT_DIR_SECTOR);
+  bitmap_mark (free_map, JOURNAL_SECTOR);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
@@ -30,13 +32,16 @@ free_map_allocate (size_t cnt, block_sector_t *sectorp)
   block_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
   if (sector != BITMAP_ERROR
       && free_map_file != NULL
-      && !bitmap_write (free_map, free_map_file))
+      && !bitmap_write_range (free_map, free_map_file, sector, cnt))
     {
       bitmap_set_multiple (free_map, sector, cnt, false); 
       sector = BITMAP_ERROR;
     }
   if (sector != BITMAP_ERROR && sector < block_size (fs_device))
-    *sectorp = sector;
+    {
+      *sectorp = sector;
+      journal_allocated (sector, cnt);
+    }
   return (sector != BITMAP_ERROR) && (sector < block_size (fs_device));
 }
 
@@ -46,7 +51,8 @@ free_map_release (block_sector_t sector, size_t cnt)
 {
   ASSERT (bitmap_all (free_map, sector, cnt));
   bitmap_set_multiple (free_map, sector, cnt, false);
-  bitmap_write (free_map, free_map_file);
+  bitmap_write_range (free_map, free_map_file, sector, cnt);
+  journal_released (sector, cnt);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -1,5 +1,6 @@
 #include "filesys/fsutil.h"
 #include <debug.h>
+#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,8 +10,18 @@
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 
+/* Size of the buffer that fsutil_extract() copies file data
+   through. */
+#define EXTRACT_PAGES 8
+#define EXTRACT_SECTORS (EXTRACT_PAGES * PGSIZE / BLOCK_SECTOR_SIZE)
+
+static void save_file (const char *file_name,
+                       size_t (*read) (size_t ofs, void *buffer, size_t size));
+
 /* List files in the root directory. */
 void
 fsutil_ls (char **argv UNUSED) 
@@ -56,6 +67,49 @@ fsutil_cat (char **argv)
   file_close (file);
 }
 
+/* Stops event tracing and saves the trace to file ARGV[1], from
+   where "pintos -g" can fetch it for utils/pintos-trace. */
+void
+fsutil_trace (char **argv) 
+{
+  trace_stop ();
+  printf ("Saving event trace to '%s'...\n", argv[1]);
+  save_file (argv[1], trace_read);
+}
+
+/* Stops profiling and saves the samples to file ARGV[1], from
+   where "pintos -g" can fetch them for utils/pintos-profile. */
+void
+fsutil_profile (char **argv) 
+{
+  profile_stop ();
+  printf ("Saving profile to '%s'...\n", argv[1]);
+  save_file (argv[1], profile_read);
+}
+
+/* Creates FILE_NAME and fills it with the bytes READ returns,
+   which is called with increasing offsets until it returns 0. */
+static void
+save_file (const char *file_name,
+           size_t (*read) (size_t ofs, void *buffer, size_t size)) 
+{
+  struct file *file;
+  void *buffer;
+  size_t ofs, n;
+
+  if (!filesys_create (file_name, 0))
+    PANIC ("%s: create failed", file_name);
+  file = filesys_open (file_name);
+  if (file == NULL)
+    PANIC ("%s: open failed", file_name);
+  buffer = palloc_get_page (PAL_ASSERT);
+  for (ofs = 0; (n = read (ofs, buffer, PGSIZE)) > 0; ofs += n)
+    if (file_write (file, buffer, n) != (off_t) n)
+      PANIC ("%s: write failed", file_name);
+  palloc_free_page (buffer);
+  file_close (file);
+}
+
 /* Deletes file ARGV[1]. */
 void
 fsutil_rm (char **argv) 
@@ -79,7 +133,7 @@ fsutil_extract (char **argv UNUSED)
 
   /* Allocate buffers. */
   header = malloc (BLOCK_SECTOR_SIZE);
-  data = malloc (BLOCK_SECTOR_SIZE);
+  data = palloc_get_multiple (0, EXTRACT_PAGES);
   if (header == NULL || data == NULL)
     PANIC ("couldn't allocate buffers");
 
@@ -110,27 +164,51 @@ fsutil_extract (char **argv UNUSED)
           break;
         }
       else if (type == USTAR_DIRECTORY)
-        printf ("ignoring directory %s\n", file_name);
+        {
+          struct dir *dir;
+
+          printf ("Putting directory '%s' into the file system...\n",
+                  file_name);
+
+          /* An archive may name a directory that already exists,
+             e.g. the root or one extracted earlier. */
+          if (!dir_create (file_name))
+            {
+              dir = open_dir (file_name);
+              if (dir == NULL)
+                PANIC ("%s: mkdir failed", file_name);
+              dir_close (dir);
+            }
+        }
       else if (type == USTAR_REGULAR)
         {
           struct file *dst;
 
           printf ("Putting '%s' into the file system...\n", file_name);
 
-          /* Create destination file. */
-          if (!filesys_create (file_name, size))
+          /* Create destination file.  Every byte of it is written
+             below, so its sectors need not be zeroed first. */
+          if (!filesys_create_unzeroed (file_name, size))
             PANIC ("%s: create failed", file_name);
           dst = filesys_open (file_name);
           if (dst == NULL)
             PANIC ("%s: open failed", file_name);
 
-          /* Do copy. */
+          /* Do copy, many sectors at a time.  Whole sectors go
+             into the buffer cache without being read first. */
           while (size > 0)
             {
-              int chunk_size = (size > BLOCK_SECTOR_SIZE
-                                ? BLOCK_SECTOR_SIZE
-                                : size);
-              block_read (src, sector++, data);
+              block_sector_t sector_cnt = DIV_ROUND_UP (size,
+                                                        BLOCK_SECTOR_SIZE);
+              int chunk_size;
+
+              if (sector_cnt > EXTRACT_SECTORS)
+                sector_cnt = EXTRACT_SECTORS;
+              chunk_size = sector_cnt * BLOCK_SECTOR_SIZE;
+              if (chunk_size > size)
+                chunk_size = size;
+              block_read_multiple (src, sector, data, sector_cnt);
+              sector += sector_cnt;
               if (file_write (dst, data, chunk_size) != chunk_size)
                 PANIC ("%s: write failed with %d bytes unwritten",
                        file_name, size);
@@ -151,7 +229,7 @@ fsutil_extract (char **argv UNUSED)
   block_write (src, 0, header);
   block_write (src, 1, header);
 
-  free (data);
+  palloc_free_multiple (data, EXTRACT_PAGES);
   free (header);
 }
 
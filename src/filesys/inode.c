@@ -6,6 +6,7 @@
 #include "filesys/cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
 
@@ -18,6 +19,11 @@
 #define IDIRECT_LIMIT   (DIRECT_LIMIT + BLOCK_SECTOR_SIZE * SECTORS_PER_BLOCK)  /* 70KB */
 #define DIDIRECT_LIMIT  (IDIRECT_LIMIT + BLOCK_SECTOR_SIZE * SECTORS_PER_BLOCK * SECTORS_PER_BLOCK) /* 8262KB */
 
+static bool create_inode (block_sector_t, off_t, uint32_t isdir, bool zero);
+static off_t read_at_locked (struct inode *, void *, off_t size, off_t offset);
+static off_t write_at_locked (struct inode *, const void *, off_t size,
+                              off_t offset);
+
 /* Returns the number of sectors to allocate for an inode SIZE
    bytes long. */
 /*
@@ -29,6 +35,14 @@ bytes_to_sectors (off_t size)
   return DIV_ROUND_UP (size, BLOCK_SECTOR_SIZE);
 }
 
+/* Returns true if INODE's data is file system metadata, which
+   goes through the journal: a directory or the free map. */
+static inline bool
+is_metadata (const struct inode *inode)
+{
+  return inode->data.flags != 0 || inode->sector == FREE_MAP_SECTOR;
+}
+
 /* Returns the block device sector that contains byte offset POS
    within INODE.
    Returns -1 if INODE does not contain data for a byte at offset
@@ -37,8 +51,9 @@ static block_sector_t
 byte_to_sector (struct inode *inode, off_t pos) 
 {
   ASSERT (inode != NULL);
+  /* Source for zero-filling newly allocated sectors */
+  static block_sector_t zeros[SECTORS_PER_BLOCK];
   /* Is it in the direct block */
-  block_sector_t *zeros = calloc(1, BLOCK_SECTOR_SIZE);
   if (pos < DIRECT_LIMIT)
   {
     // printf("%d\n", pos);
@@ -59,10 +74,9 @@ byte_to_sector (struct inode *inode, off_t pos)
           break;
         }
       }
-      cached_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+      journal_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
       sector = inode->data.dblock[pos/BLOCK_SECTOR_SIZE];
     }
-    free(zeros);
     return sector;
   }
   /* Is it in the indirect block */
@@ -71,7 +85,7 @@ byte_to_sector (struct inode *inode, off_t pos)
     if(inode->data.iblock == 0) /* Need to allocate indirect block */
     {
       free_map_allocate(1, &inode->data.iblock);
-      cached_write(inode->data.iblock, zeros, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->data.iblock, zeros, 0, BLOCK_SECTOR_SIZE);
       int i;
       /* Handle direct block */
       for(i = DIRECT_BLOCK - 1; i >= 0; i--)
@@ -86,7 +100,7 @@ byte_to_sector (struct inode *inode, off_t pos)
           break;
         }
       }
-      cached_write(inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
     }
     /* Index of the sector in the indirect block */
     uint32_t offs_b = pos/BLOCK_SECTOR_SIZE - DIRECT_BLOCK;
@@ -112,11 +126,10 @@ byte_to_sector (struct inode *inode, off_t pos)
       }
       // free_map_allocate(1, &sector);
       sector = buf[offs_b];
-      cached_write(inode->data.iblock, buf, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->data.iblock, buf, 0, BLOCK_SECTOR_SIZE);
     }
     // printf("%d\n", sector);
     free(buf);
-    free(zeros);
     return sector;
   }
   /* Is it in the doubly indirect block */
@@ -125,14 +138,14 @@ byte_to_sector (struct inode *inode, off_t pos)
     if(inode->data.diblock == 0) /* Need to allocate indirect block */
     {
       free_map_allocate(1, &inode->data.diblock);
-      cached_write(inode->data.diblock, zeros, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->data.diblock, zeros, 0, BLOCK_SECTOR_SIZE);
       int i;
       /* Handle indirect block */
       if(inode->data.iblock == 0) /* Need to allocate indirect block */
       {
       free_map_allocate(1, &inode->data.iblock);
-      cached_write(inode->data.iblock, zeros, 0, BLOCK_SECTOR_SIZE);
-      cached_write(inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->data.iblock, zeros, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
       }
       /* Load the indirect block */
       block_sector_t *buf = calloc(1, BLOCK_SECTOR_SIZE);
@@ -151,7 +164,7 @@ byte_to_sector (struct inode *inode, off_t pos)
           break;
         }
       }
-      cached_write(inode->data.iblock, buf, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->data.iblock, buf, 0, BLOCK_SECTOR_SIZE);
       free(buf);
       /* Handle direct block */
       for(i = (uint32_t) DIRECT_BLOCK - 1; i >= 0; i--)
@@ -167,7 +180,7 @@ byte_to_sector (struct inode *inode, off_t pos)
           break;
         }
       }
-      cached_write(inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
     }    
     /* Index of the sector in the doubly indirect block */
     uint32_t offs_b = pos/BLOCK_SECTOR_SIZE - DIRECT_BLOCK - SECTORS_PER_BLOCK;
@@ -205,7 +218,7 @@ byte_to_sector (struct inode *inode, off_t pos)
               break;
             }
           }
-          cached_write (buf[i], buf_i, 0, BLOCK_SECTOR_SIZE);
+          journal_write (buf[i], buf_i, 0, BLOCK_SECTOR_SIZE);
           free(buf_i);
         }
         else
@@ -213,7 +226,7 @@ byte_to_sector (struct inode *inode, off_t pos)
           break;
         }
       }
-      cached_write(inode->data.diblock, buf, 0, BLOCK_SECTOR_SIZE);
+      journal_write(inode->data.diblock, buf, 0, BLOCK_SECTOR_SIZE);
     }
     uint32_t sector = buf[offs_d];
     // printf("%d\n", sector);
@@ -236,11 +249,10 @@ byte_to_sector (struct inode *inode, off_t pos)
           break;
         }
       }
+      journal_write(sector, buf, 0, BLOCK_SECTOR_SIZE);
     }
-    cached_write(sector, buf, 0, BLOCK_SECTOR_SIZE);
     sector = buf[offs_i];
     free(buf);
-    free(zeros);
     return sector;
   }
 }
@@ -249,11 +261,19 @@ byte_to_sector (struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Object cache for in-memory inodes. */
+static struct obj_cache *inode_cache;
+
+/* Called by inode_remove(), see inode_set_remove_hook(). */
+static void (*remove_hook) (struct inode *);
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  inode_cache = obj_cache_create ("inode", sizeof (struct inode));
+  ASSERT (inode_cache != NULL);
 }
 
 void map_sector_to_inode(block_sector_t *sectors_idx, 
@@ -326,10 +346,18 @@ void map_sector_to_inode(block_sector_t *sectors_idx,
 /* 
 Allocate cnt free sector, not neccessarily consecutive
 Return the sector index to the array
+A single contiguous run is tried first, so that the file can be read sequentially
 */
 bool sectors_allocate(size_t cnt, block_sector_t *arr)
 {
   uint32_t i;
+  block_sector_t start;
+  if(cnt > 1 && free_map_allocate(cnt, &start))
+  {
+    for(i = 0; i < cnt; i++)
+      arr[i] = start + i;
+    return true;
+  }
   for(i = 0; i < cnt; i++)
   {
     if(!free_map_allocate(1, &arr[i]))
@@ -399,6 +427,23 @@ void sectors_release(struct inode_disk *disk_inode)
    Returns false if memory or disk allocation fails. */
 bool
 inode_create (block_sector_t sector, off_t length, uint32_t isdir)
+{
+  return create_inode (sector, length, isdir, true);
+}
+
+/* Like inode_create(), but leaves the data sectors as they were
+   on disk instead of zeroing them.  Only for a caller that is
+   about to write all LENGTH bytes itself, e.g. fsutil_extract(). */
+bool
+inode_create_unzeroed (block_sector_t sector, off_t length, uint32_t isdir)
+{
+  return create_inode (sector, length, isdir, false);
+}
+
+/* Does the work for inode_create(); the data sectors are zeroed
+   only if ZERO is true */
+static bool
+create_inode (block_sector_t sector, off_t length, uint32_t isdir, bool zero)
 {
   struct inode_disk *disk_inode = NULL;
   bool success = false;
@@ -435,7 +480,7 @@ inode_create (block_sector_t sector, off_t length, uint32_t isdir)
     // printf("%x %x\n", iblock, diblock);
     /* Write the inode to disk */
     DBG_MSG_FS("[FS - %s] writing new direct block\n", thread_name());
-    cached_write (sector, disk_inode, 0, BLOCK_SECTOR_SIZE);
+    journal_write (sector, disk_inode, 0, BLOCK_SECTOR_SIZE);
     /* Write the indirect block */
     if(iblock != NULL)
     {
@@ -445,20 +490,20 @@ inode_create (block_sector_t sector, off_t length, uint32_t isdir)
       //     DBG_MSG_FS("%d ", iblock[i]);
       // }
       // DBG_MSG_FS("\n");
-      cached_write(disk_inode->iblock, iblock, 0, BLOCK_SECTOR_SIZE);
+      journal_write(disk_inode->iblock, iblock, 0, BLOCK_SECTOR_SIZE);
       free(iblock);
     }
     if(diblock != NULL)
     {
       DBG_MSG_FS("[FS - %s] writing new doubly indirect block %d\n", thread_name(), disk_inode->diblock);
-      cached_write(disk_inode->diblock, diblock_i, 0, BLOCK_SECTOR_SIZE);
+      journal_write(disk_inode->diblock, diblock_i, 0, BLOCK_SECTOR_SIZE);
       uint32_t i;
       for(i = 0; i < SECTORS_PER_BLOCK; i++)
       {
         if(diblock[i] != NULL)
         {
           DBG_MSG_FS("[FS - %s] writing new doubly indirect entry %d\n", thread_name(), diblock_i[i]);
-          cached_write(diblock_i[i], diblock[i], 0, BLOCK_SECTOR_SIZE);
+          journal_write(diblock_i[i], diblock[i], 0, BLOCK_SECTOR_SIZE);
           free(diblock[i]);
         }
         else
@@ -469,7 +514,7 @@ inode_create (block_sector_t sector, off_t length, uint32_t isdir)
       free(diblock);
       free(diblock_i);
     }
-    if (sectors > 0) 
+    if (sectors > 0 && zero) 
       {
         static char zeros[BLOCK_SECTOR_SIZE];
         size_t i;
@@ -508,7 +553,7 @@ inode_open (block_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = obj_cache_alloc (inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -518,6 +563,7 @@ inode_open (block_sector_t sector)
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
+  inode->write_gen = 0;
   rwlock_init(&inode->rw);
   lock_init(&inode->lock);
   cached_read (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
@@ -555,8 +601,9 @@ inode_close (struct inode *inode)
   if (inode == NULL)
     return;
   // printf("close %d\n", inode->sector);
-  cached_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
-  // disk_cache_flush_all();
+  /* Every change to the on-disk inode has already been written, so
+     there is nothing to write back here. */
+  journal_begin();
   /* Release resources if this was the last opener. */
   lock_acquire(&inode->lock);
   inode->open_cnt--;
@@ -574,9 +621,9 @@ inode_close (struct inode *inode)
           free_map_release (inode->sector, 1);
           sectors_release (&inode->data);        
         }
-      free (inode); 
+      obj_cache_free (inode_cache, inode); 
     }
-  disk_cache_flush_all();
+  journal_end();
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -588,6 +635,18 @@ inode_remove (struct inode *inode)
   ASSERT (inode != NULL);
   inode->removed = true;
   lock_release(&inode->lock);
+  if (remove_hook != NULL)
+    remove_hook (inode);
+}
+
+/* Arranges for HOOK to be called with each inode that is marked
+   removed, so a cache that keeps inodes open can let go of them
+   and their sectors can be freed.  HOOK runs while the caller of
+   inode_remove() still has the inode open. */
+void
+inode_set_remove_hook (void (*hook) (struct inode *)) 
+{
+  remove_hook = hook;
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -597,12 +656,47 @@ inode_remove (struct inode *inode)
   Read file --> read the inode --> locate the disk block --> o to the disk block
 */
 off_t
-inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) 
+inode_read_at (struct inode *inode, void *buffer, off_t size, off_t offset) 
+{
+  off_t bytes_read;
+  ASSERT(offset <= inode_length(inode));
+  rwlock_acquire_read(&inode->rw);
+  bytes_read = read_at_locked(inode, buffer, size, offset);
+  rwlock_release_read(&inode->rw);
+  return bytes_read;
+}
+
+/* Reads into the CNT buffers of IOV, in order, from INODE
+   starting at position OFFSET, taking the inode's read lock
+   once for the whole list.  Returns the number of bytes read,
+   which is short if end of file is reached. */
+off_t
+inode_readv_at (struct inode *inode, const struct iovec *iov, int cnt,
+                off_t offset) 
+{
+  off_t bytes_read = 0;
+  int i;
+
+  rwlock_acquire_read(&inode->rw);
+  for (i = 0; i < cnt && offset + bytes_read < inode_length(inode); i++)
+  {
+    off_t n = read_at_locked(inode, iov[i].iov_base, iov[i].iov_len,
+                             offset + bytes_read);
+    bytes_read += n;
+    if (n < (off_t) iov[i].iov_len)
+      break;
+  }
+  rwlock_release_read(&inode->rw);
+  return bytes_read;
+}
+
+/* Reads SIZE bytes from INODE into BUFFER, starting at OFFSET.
+   The caller must hold INODE's read or write lock. */
+static off_t
+read_at_locked (struct inode *inode, void *buffer_, off_t size, off_t offset) 
 {
   uint8_t *buffer = buffer_;
   off_t bytes_read = 0;
-  ASSERT(offset <= inode_length(inode));
-  rwlock_acquire_read_lock(&inode->rw);
   while (size > 0) 
   {
     int sector_ofs = offset % BLOCK_SECTOR_SIZE;
@@ -627,7 +721,6 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
     offset += chunk_size;
     bytes_read += chunk_size;
   }
-  rwlock_release_read_lock(&inode->rw);
   return bytes_read;
 }
 
@@ -637,15 +730,112 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
    (Normally a write at end of file would extend the inode, but
    growth is not yet implemented.) */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
                 off_t offset) 
 {
-  const uint8_t *buffer = buffer_;
+  off_t bytes_written;
+
+  if (inode->deny_write_cnt)
+    return 0;
+  journal_begin();
+  rwlock_acquire_write(&inode->rw);
+  bytes_written = write_at_locked(inode, buffer, size, offset);
+  rwlock_release_write(&inode->rw);
+  journal_end();
+  return bytes_written;
+}
+
+/* Writes the CNT buffers of IOV, in order, into INODE starting
+   at OFFSET, taking the inode's write lock once for the whole
+   list.  Returns the number of bytes written. */
+off_t
+inode_writev_at (struct inode *inode, const struct iovec *iov, int cnt,
+                 off_t offset) 
+{
   off_t bytes_written = 0;
+  int i;
 
   if (inode->deny_write_cnt)
     return 0;
-  rwlock_acquire_write_lock(&inode->rw);
+  journal_begin();
+  rwlock_acquire_write(&inode->rw);
+  for (i = 0; i < cnt; i++)
+  {
+    off_t n = write_at_locked(inode, iov[i].iov_base, iov[i].iov_len,
+                              offset + bytes_written);
+    bytes_written += n;
+    if (n < (off_t) iov[i].iov_len)
+      break;
+  }
+  rwlock_release_write(&inode->rw);
+  journal_end();
+  return bytes_written;
+}
+
+/* Copies up to SIZE bytes of SRC starting at SRC_OFS into DST at
+   DST_OFS, one sector at a time, from buffer cache to buffer
+   cache through a sector-sized bounce buffer.  Stops at the end of
+   SRC or on a short write to DST.  SRC and DST may be the same
+   inode.  Returns the number of bytes copied, or -1 if writes to
+   DST are denied. */
+off_t
+inode_copy_range (struct inode *dst, off_t dst_ofs,
+                  struct inode *src, off_t src_ofs, off_t size) 
+{
+  uint8_t sector_buf[BLOCK_SECTOR_SIZE];
+  off_t bytes_copied = 0;
+
+  if (dst->deny_write_cnt)
+    return -1;
+  while (size > 0)
+  {
+    /* Copy up to the end of the current source sector, so each
+       chunk is a single cached_read(). */
+    int sector_ofs = src_ofs % BLOCK_SECTOR_SIZE;
+    int chunk_size = BLOCK_SECTOR_SIZE - sector_ofs;
+    off_t n;
+    if (chunk_size > size)
+      chunk_size = size;
+
+    rwlock_acquire_read(&src->rw);
+    if (src_ofs >= inode_length (src))
+    {
+      rwlock_release_read(&src->rw);
+      break;
+    }
+    if (chunk_size > inode_length (src) - src_ofs)
+      chunk_size = inode_length (src) - src_ofs;
+    cached_read(byte_to_sector (src, src_ofs), sector_buf, sector_ofs,
+                chunk_size);
+    rwlock_release_read(&src->rw);
+
+    journal_begin();
+    rwlock_acquire_write(&dst->rw);
+    n = write_at_locked(dst, sector_buf, chunk_size, dst_ofs);
+    rwlock_release_write(&dst->rw);
+    journal_end();
+
+    bytes_copied += n;
+    if (n < chunk_size)
+      break;
+    size -= chunk_size;
+    src_ofs += chunk_size;
+    dst_ofs += chunk_size;
+  }
+  return bytes_copied;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE at OFFSET, extending
+   the inode if needed.  The caller must hold INODE's write
+   lock. */
+static off_t
+write_at_locked (struct inode *inode, const void *buffer_, off_t size,
+                 off_t offset) 
+{
+  const uint8_t *buffer = buffer_;
+  off_t bytes_written = 0;
+
+  inode->write_gen++;
   while (size > 0) 
   {
     /* Sector to write, starting byte offset within sector. */
@@ -666,7 +856,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
     DBG_MSG_FS("[FS - %s] write to sector %d size %d\n", thread_name(), sector_idx, chunk_size);
     
-    cached_write(sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
+    if (is_metadata(inode))
+      journal_write(sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
+    else
+      cached_write(sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
     
     /* Advance. */
     size -= chunk_size;
@@ -674,9 +867,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
     bytes_written += chunk_size;
   }
   uint32_t newlen = (offset >= inode_length(inode))?offset:inode_length(inode);
-  inode_length_set(inode, newlen);
-  // cached_write (inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
-  rwlock_release_write_lock(&inode->rw);
+  if (newlen != (uint32_t) inode_length(inode))
+  {
+    inode_length_set(inode, newlen);
+    journal_write(inode->sector, &inode->data, 0, BLOCK_SECTOR_SIZE);
+  }
   return bytes_written;
 }
 
@@ -711,9 +906,34 @@ inode_length (const struct inode *inode)
   return inode->data.length;
 }
 
+/* Returns the sector that holds byte POS of INODE, which must be
+   less than its length. */
+block_sector_t
+inode_sector_at (struct inode *inode, off_t pos)
+{
+  ASSERT (pos < inode_length (inode));
+  return byte_to_sector (inode, pos);
+}
+
 void inode_length_set (struct inode *inode, uint32_t newlen)
 {
   lock_acquire(&inode->lock);
   inode->data.length = newlen;
   lock_release(&inode->lock);
+}
+
+/* Returns INODE's write generation, which changes whenever INODE
+   is written, so a caller can tell whether data it derived from
+   the file is still current. */
+unsigned
+inode_write_gen (const struct inode *inode)
+{
+  return inode->write_gen;
+}
+
+/* Returns true if INODE has been removed. */
+bool
+inode_is_removed (const struct inode *inode)
+{
+  return inode->removed;
 }
\ No newline at end of file
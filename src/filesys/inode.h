@@ -6,6 +6,7 @@
 #include "devices/block.h"
 #include "filesys/cache.h"
 #include "threads/synch.h"
+#include <iovec.h>
 struct bitmap;
 
 /* Inode index parametter */
@@ -44,7 +45,8 @@ struct inode
   int open_cnt;                       /* Number of openers. */
   bool removed;                       /* True if deleted, false otherwise. */
   int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
-  struct _rw_lock rw;
+  unsigned write_gen;                 /* Bumped by every write. */
+  struct rwlock rw;                   /* Serializes writers against readers. */
   struct inode_disk data;             /* Inode content. */
   struct lock lock;
 };
@@ -57,16 +59,27 @@ struct inode
 
 void inode_init (void);
 bool inode_create (block_sector_t, off_t, uint32_t isdir);
+bool inode_create_unzeroed (block_sector_t, off_t, uint32_t isdir);
 struct inode *inode_open (block_sector_t);
 struct inode *inode_reopen (struct inode *);
 block_sector_t inode_get_inumber (const struct inode *);
 void inode_close (struct inode *);
 void inode_remove (struct inode *);
+void inode_set_remove_hook (void (*hook) (struct inode *));
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_readv_at (struct inode *, const struct iovec *, int cnt,
+                      off_t offset);
+off_t inode_writev_at (struct inode *, const struct iovec *, int cnt,
+                       off_t offset);
+off_t inode_copy_range (struct inode *dst, off_t dst_ofs,
+                        struct inode *src, off_t src_ofs, off_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
 void inode_length_set (struct inode *inode, uint32_t newlen);
+block_sector_t inode_sector_at (struct inode *, off_t pos);
+unsigned inode_write_gen (const struct inode *);
+bool inode_is_removed (const struct inode *);
 
 #endif /* filesys/inode.h */
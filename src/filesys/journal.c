@@ -0,0 +1,424 @@
+#include "filesys/journal.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "filesys/cache.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/perf.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Write-ahead journal for file system metadata.
+
+   Free map sectors, inodes, index blocks and directory data are
+   written with journal_write() instead of straight into the
+   buffer cache.  Each such sector is held in the cache, where it
+   cannot be written back, until the transaction that changed it
+   commits: its contents are appended to the log, a file with a
+   fixed inode at JOURNAL_SECTOR, and then the log header, which
+   lists the home sector of every logged copy, is rewritten.
+   Writing the header is the commit point.  After that the
+   sectors may go home whenever the cache gets to them, and
+   filesys_init() copies the log back over them if the machine
+   stopped first.  When the log fills up, the whole cache is
+   flushed and the log starts over.
+
+   A file system operation is bracketed by journal_begin() and
+   journal_end().  Operations in different threads join the same
+   transaction, which commits when the last of them ends, so
+   concurrent creates and removes share one log write.  An
+   operation waits in journal_begin() if the running transaction
+   might not have room for it.
+
+   An operation that fills the transaction by itself, such as
+   removing a large file whose free map bits are spread across the
+   disk, commits what has been logged so far and carries on in a
+   new transaction.  The file system allocates before it links and
+   unlinks before it frees, so a crash between the two commits can
+   only leak sectors, never leave one in use twice.
+
+   Sectors allocated during the running transaction are not
+   logged, since nothing that has committed refers to them yet;
+   whatever the cache holds for them, file data included, is
+   written home before the transaction commits, so a committed
+   inode never points at a deleted file's data.  A sector freed
+   during the transaction has any copies of it in the log revoked,
+   so that replay cannot overwrite whatever it holds next.
+
+   File data is not journaled. */
+
+/* Identifies a log header. */
+#define JOURNAL_MAGIC 0x4c4e524a
+
+/* Number of sectors the log holds, not counting its header. */
+#define JOURNAL_SLOTS 126
+
+/* Most sectors that one transaction may log.  These are held in
+   the buffer cache until the transaction commits, so this must be
+   well under CACHE_SIZE. */
+#define TXN_SECTORS 30
+
+/* Sectors set aside for each operation in journal_begin().  One
+   that logs more eats into the room left for others, and may have
+   to commit early if the transaction fills up. */
+#define OP_SECTORS 10
+
+/* Marks a log entry revoked. */
+#define REVOKED ((block_sector_t) -1)
+
+/* Log header, in the first sector of the log.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct journal_header
+  {
+    uint32_t magic;                     /* JOURNAL_MAGIC. */
+    uint32_t cnt;                       /* Number of committed entries. */
+    block_sector_t sectors[JOURNAL_SLOTS]; /* Home of each entry. */
+  };
+
+/* True once journal_init() has replayed the log.  Until then,
+   metadata is written straight into the cache. */
+static bool active;
+
+static struct lock journal_lock;        /* Protects the state below. */
+static struct condition journal_space;  /* Signaled when ops may begin. */
+static int outstanding;                 /* Operations in progress. */
+static bool committing;                 /* Is commit() running? */
+
+/* The log: LOG_SECTORS[0] holds the header, LOG_SECTORS[I] the
+   entry in slot I - 1.  HEADER is the committed header. */
+static block_sector_t log_sectors[JOURNAL_SLOTS + 1];
+static struct journal_header header;
+
+/* The running transaction.  TXN lists the sectors it logs.
+   FRESH has a bit for each sector it allocated and RELEASED for
+   each sector it freed. */
+static block_sector_t txn[TXN_SECTORS];
+static size_t txn_cnt;
+static struct bitmap *fresh;
+static struct bitmap *released;
+
+static void find_log (void);
+static void replay (void);
+static void commit (void);
+static void checkpoint (void);
+static void write_header (void);
+static size_t txn_find (block_sector_t);
+
+/* Creates the log on a newly formatted file system. */
+void
+journal_create (void)
+{
+  /* The log is only ever written whole sectors at a time, and
+     an empty one is just its header. */
+  if (!inode_create_unzeroed (JOURNAL_SECTOR,
+                              (JOURNAL_SLOTS + 1) * BLOCK_SECTOR_SIZE, 0))
+    PANIC ("journal creation failed");
+  find_log ();
+  header.magic = JOURNAL_MAGIC;
+  header.cnt = 0;
+  write_header ();
+}
+
+/* Opens the log, replays whatever it holds, and starts
+   journaling metadata writes.  Must be called before anything
+   else reads metadata from the file system. */
+void
+journal_init (void)
+{
+  ASSERT (sizeof header == BLOCK_SECTOR_SIZE);
+
+  lock_init (&journal_lock);
+  cond_init (&journal_space);
+  find_log ();
+  block_read (fs_device, log_sectors[0], &header);
+  if (header.magic != JOURNAL_MAGIC || header.cnt > JOURNAL_SLOTS)
+    PANIC ("bad journal header (reformat the file system with -f)");
+  if (header.cnt > 0)
+    replay ();
+
+  fresh = bitmap_create (block_size (fs_device));
+  released = bitmap_create (block_size (fs_device));
+  if (fresh == NULL || released == NULL)
+    PANIC ("journal bitmap creation failed");
+  active = true;
+}
+
+/* Waits for operations in progress to finish, then writes
+   everything the log holds to its home and empties the log, so
+   that the next boot has nothing to replay. */
+void
+journal_done (void)
+{
+  if (!active)
+    return;
+  lock_acquire (&journal_lock);
+  while (outstanding > 0 || committing)
+    cond_wait (&journal_space, &journal_lock);
+  committing = true;
+  lock_release (&journal_lock);
+
+  checkpoint ();
+}
+
+/* Begins a file system operation, first waiting until the
+   running transaction has room for it.  Operations nest: only
+   the outermost journal_begin() and journal_end() of a thread
+   count.  The outermost call must not be made while holding a
+   lock that an operation in progress might need. */
+void
+journal_begin (void)
+{
+  if (!active || thread_current ()->journal_depth++ > 0)
+    return;
+
+  lock_acquire (&journal_lock);
+  while (committing
+         || txn_cnt + (outstanding + 1) * OP_SECTORS > TXN_SECTORS)
+    cond_wait (&journal_space, &journal_lock);
+  outstanding++;
+  lock_release (&journal_lock);
+}
+
+/* Ends a file system operation.  The last operation of a
+   transaction to end commits it. */
+void
+journal_end (void)
+{
+  bool do_commit = false;
+
+  if (!active)
+    return;
+  ASSERT (thread_current ()->journal_depth > 0);
+  if (--thread_current ()->journal_depth > 0)
+    return;
+
+  lock_acquire (&journal_lock);
+  outstanding--;
+  if (outstanding == 0)
+    {
+      committing = true;
+      do_commit = true;
+    }
+  else
+    {
+      /* This operation's reservation may let another begin. */
+      cond_broadcast (&journal_space, &journal_lock);
+    }
+  lock_release (&journal_lock);
+
+  if (do_commit)
+    {
+      /* No operation is in progress, so nothing can change the
+         transaction while it is written out without the lock. */
+      commit ();
+      lock_acquire (&journal_lock);
+      committing = false;
+      cond_broadcast (&journal_space, &journal_lock);
+      lock_release (&journal_lock);
+    }
+}
+
+/* Writes SIZE bytes from DATA at offset OFS within metadata
+   sector SECTOR, as part of the running transaction.  Outside
+   journal_begin() and journal_end(), the write is an operation
+   of its own. */
+void
+journal_write (block_sector_t sector, const void *data, size_t ofs,
+               size_t size)
+{
+  bool own_op;
+
+  ASSERT (ofs + size <= BLOCK_SECTOR_SIZE);
+  if (!active)
+    {
+      cached_write (sector, (void *) data, ofs, size);
+      return;
+    }
+
+  own_op = thread_current ()->journal_depth == 0;
+  if (own_op)
+    journal_begin ();
+
+  /* The lock is held across the cache write, so that a commit
+     made from here by another operation sees each sector either
+     before it joins the transaction or with its new contents. */
+  lock_acquire (&journal_lock);
+  if (bitmap_test (fresh, sector))
+    cached_write (sector, (void *) data, ofs, size);
+  else
+    {
+      if (txn_find (sector) == txn_cnt)
+        {
+          if (txn_cnt >= TXN_SECTORS)
+            {
+              /* Commit and continue.  Operations in progress
+                 cannot log anything while the lock is held, and
+                 new ones wait for COMMITTING to clear. */
+              committing = true;
+              commit ();
+              committing = false;
+              cond_broadcast (&journal_space, &journal_lock);
+            }
+          txn[txn_cnt++] = sector;
+        }
+      cached_write_logged (sector, (void *) data, ofs, size);
+    }
+  lock_release (&journal_lock);
+
+  if (own_op)
+    journal_end ();
+}
+
+/* Notes that the free map allocated CNT sectors starting at
+   SECTOR in the running transaction. */
+void
+journal_allocated (block_sector_t sector, size_t cnt)
+{
+  if (!active)
+    return;
+  lock_acquire (&journal_lock);
+  bitmap_set_multiple (fresh, sector, cnt, true);
+  lock_release (&journal_lock);
+}
+
+/* Notes that the free map freed CNT sectors starting at SECTOR
+   in the running transaction.  They no longer need logging, and
+   their old log entries are revoked when it commits. */
+void
+journal_released (block_sector_t sector, size_t cnt)
+{
+  block_sector_t last = sector + cnt;
+
+  if (!active)
+    return;
+  lock_acquire (&journal_lock);
+  bitmap_set_multiple (released, sector, cnt, true);
+  bitmap_set_multiple (fresh, sector, cnt, false);
+  for (; sector < last; sector++)
+    {
+      size_t i = txn_find (sector);
+      if (i < txn_cnt)
+        {
+          txn[i] = txn[--txn_cnt];
+          disk_cache_unlog (sector);
+        }
+    }
+  lock_release (&journal_lock);
+}
+
+/* Looks up the log's sectors in the journal file's inode. */
+static void
+find_log (void)
+{
+  struct inode *inode = inode_open (JOURNAL_SECTOR);
+  size_t i;
+
+  if (inode == NULL
+      || inode_length (inode) != (JOURNAL_SLOTS + 1) * BLOCK_SECTOR_SIZE)
+    PANIC ("no journal (reformat the file system with -f)");
+  for (i = 0; i <= JOURNAL_SLOTS; i++)
+    log_sectors[i] = inode_sector_at (inode, i * BLOCK_SECTOR_SIZE);
+  inode_close (inode);
+}
+
+/* Copies the committed log entries to their homes, in order, so
+   that the latest copy of each sector wins, and empties the
+   log. */
+static void
+replay (void)
+{
+  static uint8_t buffer[BLOCK_SECTOR_SIZE];
+  size_t cnt = 0;
+  size_t i;
+
+  for (i = 0; i < header.cnt; i++)
+    if (header.sectors[i] != REVOKED)
+      {
+        block_read (fs_device, log_sectors[i + 1], buffer);
+        cached_write (header.sectors[i], buffer, 0, BLOCK_SECTOR_SIZE);
+        cnt++;
+      }
+  printf ("journal: replayed %zu sectors\n", cnt);
+  checkpoint ();
+}
+
+/* Commits the running transaction.  Called with no operation in
+   progress, or with JOURNAL_LOCK held so that none can log
+   anything. */
+static void
+commit (void)
+{
+  static uint8_t buffer[BLOCK_SECTOR_SIZE];
+  bool revoked = false;
+  size_t s;
+  size_t i;
+
+  /* What the transaction allocated goes home first, ahead of the
+     metadata that refers to it. */
+  for (s = bitmap_scan (fresh, 0, 1, true); s != BITMAP_ERROR;
+       s = bitmap_scan (fresh, s + 1, 1, true))
+    disk_cache_flush (s);
+
+  for (i = 0; i < header.cnt; i++)
+    if (header.sectors[i] != REVOKED
+        && bitmap_test (released, header.sectors[i]))
+      {
+        header.sectors[i] = REVOKED;
+        revoked = true;
+      }
+
+  if (txn_cnt > 0 || revoked)
+    {
+      ASSERT (header.cnt + txn_cnt <= JOURNAL_SLOTS);
+      for (i = 0; i < txn_cnt; i++)
+        {
+          cached_read (txn[i], buffer, 0, BLOCK_SECTOR_SIZE);
+          block_write (fs_device, log_sectors[header.cnt + 1], buffer);
+          header.sectors[header.cnt++] = txn[i];
+          perf_inc (PERF_JOURNAL_WRITE);
+        }
+      write_header ();
+      perf_inc (PERF_JOURNAL_COMMIT);
+
+      for (i = 0; i < txn_cnt; i++)
+        disk_cache_unlog (txn[i]);
+      txn_cnt = 0;
+    }
+  bitmap_set_all (fresh, false);
+  bitmap_set_all (released, false);
+
+  /* Make sure the next transaction fits. */
+  if (header.cnt + TXN_SECTORS > JOURNAL_SLOTS)
+    checkpoint ();
+}
+
+/* Writes every committed sector to its home and empties the
+   log.  Called with no transaction running. */
+static void
+checkpoint (void)
+{
+  disk_cache_flush_all ();
+  header.cnt = 0;
+  write_header ();
+}
+
+/* Writes the log header to disk. */
+static void
+write_header (void)
+{
+  block_write (fs_device, log_sectors[0], &header);
+}
+
+/* Returns the index of SECTOR in the running transaction, or
+   TXN_CNT if it is not there. */
+static size_t
+txn_find (block_sector_t sector)
+{
+  size_t i;
+
+  for (i = 0; i < txn_cnt; i++)
+    if (txn[i] == sector)
+      break;
+  return i;
+}
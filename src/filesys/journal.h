@@ -0,0 +1,24 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/block.h"
+
+/* Setting up and shutting down. */
+void journal_create (void);
+void journal_init (void);
+void journal_done (void);
+
+/* Bracketing a file system operation. */
+void journal_begin (void);
+void journal_end (void);
+
+/* Metadata updates. */
+void journal_write (block_sector_t, const void *, size_t ofs, size_t size);
+
+/* Notifications from the free map. */
+void journal_allocated (block_sector_t, size_t cnt);
+void journal_released (block_sector_t, size_t cnt);
+
+#endif /* filesys/journal.h */
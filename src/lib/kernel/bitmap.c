@@ -3,6 +3,7 @@
 #include <limits.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 #ifdef FILESYS
 #include "filesys/file.h"
@@ -23,11 +24,20 @@ typedef unsigned long elem_type;
 
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   Two summary arrays sit on top of BITS, with one bit per
+   element of BITS: bit I of FULL is set if element I has all of
+   its bits set, and bit I of EMPTY is set if element I has none
+   set.  bitmap_scan() uses them to step over ELEM_BITS elements
+   (ELEM_BITS * ELEM_BITS bits) at a time in regions that cannot
+   hold a match. */
 struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    elem_type *full;    /* Elements of BITS that are all ones. */
+    elem_type *empty;   /* Elements of BITS that are all zeros. */
   };
 
 /* Returns the index of the element that contains the bit
@@ -60,6 +70,14 @@ byte_cnt (size_t bit_cnt)
   return sizeof (elem_type) * elem_cnt (bit_cnt);
 }
 
+/* Returns the number of bytes required for BIT_CNT bits along
+   with their two summary arrays. */
+static inline size_t
+storage_cnt (size_t bit_cnt)
+{
+  return byte_cnt (bit_cnt) + 2 * byte_cnt (elem_cnt (bit_cnt));
+}
+
 /* Returns a bit mask in which the bits actually used in the last
    element of B's bits are set to 1 and the rest are set to 0. */
 static inline elem_type
@@ -68,6 +86,66 @@ last_mask (const struct bitmap *b)
   int last_bits = b->bit_cnt % ELEM_BITS;
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns a mask of the bits of element IDX in B that are part
+   of the bitmap. */
+static inline elem_type
+used_mask (const struct bitmap *b, size_t idx) 
+{
+  return idx == elem_cnt (b->bit_cnt) - 1 ? last_mask (b) : (elem_type) -1;
+}
+
+/* Points B's summary arrays into the storage that follows its
+   bits. */
+static void
+set_summary_storage (struct bitmap *b) 
+{
+  b->full = b->bits + elem_cnt (b->bit_cnt);
+  b->empty = b->full + elem_cnt (elem_cnt (b->bit_cnt));
+}
+
+/* Brings the FULL and EMPTY summary bits for element IDX of B up
+   to date with its contents. */
+static inline void
+update_summary (struct bitmap *b, size_t idx) 
+{
+  elem_type used = used_mask (b, idx);
+  elem_type value = b->bits[idx] & used;
+
+  if (value == used)
+    b->full[elem_idx (idx)] |= bit_mask (idx);
+  else
+    b->full[elem_idx (idx)] &= ~bit_mask (idx);
+  if (value == 0)
+    b->empty[elem_idx (idx)] |= bit_mask (idx);
+  else
+    b->empty[elem_idx (idx)] &= ~bit_mask (idx);
+}
+
+/* Returns the number of bits set in X. */
+static inline size_t
+count_ones (elem_type x) 
+{
+  size_t cnt = 0;
+  for (; x != 0; x &= x - 1)
+    cnt++;
+  return cnt;
+}
+
+/* Returns a mask of the bits of element IDX that fall within the
+   bit range from START to START + CNT, exclusive.  Element IDX
+   must overlap that range. */
+static inline elem_type
+range_mask (size_t idx, size_t start, size_t cnt) 
+{
+  size_t first = idx * ELEM_BITS;
+  size_t lo = start > first ? start - first : 0;
+  size_t hi = start + cnt - first < ELEM_BITS ? start + cnt - first : ELEM_BITS;
+  elem_type mask = (elem_type) -1 << lo;
+  if (hi < ELEM_BITS)
+    mask &= ((elem_type) 1 << hi) - 1;
+  return mask;
+}
 
 /* Creation and destruction. */
 
@@ -82,9 +160,10 @@ bitmap_create (size_t bit_cnt)
   if (b != NULL)
     {
       b->bit_cnt = bit_cnt;
-      b->bits = malloc (byte_cnt (bit_cnt));
+      b->bits = malloc (storage_cnt (bit_cnt));
       if (b->bits != NULL || bit_cnt == 0)
         {
+          set_summary_storage (b);
           bitmap_set_all (b, false);
           return b;
         }
@@ -105,6 +184,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  set_summary_storage (b);
   bitmap_set_all (b, false);
   return b;
 }
@@ -114,7 +194,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 size_t
 bitmap_buf_size (size_t bit_cnt) 
 {
-  return sizeof (struct bitmap) + byte_cnt (bit_cnt);
+  return sizeof (struct bitmap) + storage_cnt (bit_cnt);
 }
 
 /* Destroys bitmap B, freeing its storage.
@@ -152,7 +232,9 @@ bitmap_set (struct bitmap *b, size_t idx, bool value)
     bitmap_reset (b, idx);
 }
 
-/* Atomically sets the bit numbered BIT_IDX in B to true. */
+/* Atomically sets the bit numbered BIT_IDX in B to true.
+   Interrupts are held off across the update of the bit and its
+   summary, so an interrupt handler never sees them disagree. */
 void
 bitmap_mark (struct bitmap *b, size_t bit_idx) 
 {
@@ -162,7 +244,10 @@ bitmap_mark (struct bitmap *b, size_t bit_idx)
   /* This is equivalent to `b->bits[idx] |= mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the OR instruction in [IA32-v2b]. */
+  enum intr_level old_level = intr_disable ();
   asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
+  intr_set_level (old_level);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -175,7 +260,10 @@ bitmap_reset (struct bitmap *b, size_t bit_idx)
   /* This is equivalent to `b->bits[idx] &= ~mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the AND instruction in [IA32-v2a]. */
+  enum intr_level old_level = intr_disable ();
   asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+  update_summary (b, idx);
+  intr_set_level (old_level);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -190,7 +278,10 @@ bitmap_flip (struct bitmap *b, size_t bit_idx)
   /* This is equivalent to `b->bits[idx] ^= mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the XOR instruction in [IA32-v2b]. */
+  enum intr_level old_level = intr_disable ();
   asm ("xorl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
+  intr_set_level (old_level);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -217,14 +308,26 @@ bitmap_set_all (struct bitmap *b, bool value)
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  enum intr_level old_level;
   size_t i;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  if (cnt == 0)
+    return;
+  old_level = intr_disable ();
+  for (i = elem_idx (start); i <= elem_idx (start + cnt - 1); i++)
+    {
+      elem_type mask = range_mask (i, start, cnt);
+      if (value)
+        b->bits[i] |= mask;
+      else
+        b->bits[i] &= ~mask;
+      update_summary (b, i);
+    }
+  intr_set_level (old_level);
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -232,17 +335,18 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i, value_cnt;
+  size_t i, ones;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
-  return value_cnt;
+  if (cnt == 0)
+    return 0;
+  ones = 0;
+  for (i = elem_idx (start); i <= elem_idx (start + cnt - 1); i++)
+    ones += count_ones (b->bits[i] & range_mask (i, start, cnt));
+  return value ? ones : cnt - ones;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -256,9 +360,14 @@ bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
+  if (cnt == 0)
+    return false;
+  for (i = elem_idx (start); i <= elem_idx (start + cnt - 1); i++)
+    {
+      elem_type bits = value ? b->bits[i] : ~b->bits[i];
+      if ((bits & range_mask (i, start, cnt)) != 0)
+        return true;
+    }
   return false;
 }
 
@@ -291,20 +400,94 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt)
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+
+   The scan goes a word at a time, tracking the run of VALUE
+   bits that ends at the current word and using find-first-set
+   to walk the runs inside mixed words.  A summary word that says
+   ELEM_BITS elements in a row hold no VALUE bit at all skips all
+   of them at once, so a nearly full bitmap is not walked bit by
+   bit. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  const elem_type *skip;
+  size_t elem_total, run_start, run_len, i;
+
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
-  if (cnt <= b->bit_cnt) 
+  if (cnt > b->bit_cnt - start)
+    return BITMAP_ERROR;
+  if (cnt == 0)
+    return start;
+
+  /* Elements marked in SKIP hold no bit equal to VALUE. */
+  skip = value ? b->empty : b->full;
+  elem_total = elem_cnt (b->bit_cnt);
+  run_start = start;
+  run_len = 0;
+  i = elem_idx (start);
+  while (i < elem_total)
     {
-      size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      elem_type bits;
+      size_t pos;
+
+      /* Skip a whole group of elements without a match. */
+      if (i % ELEM_BITS == 0 && i + ELEM_BITS <= elem_total
+          && skip[elem_idx (i)] == (elem_type) -1)
+        {
+          run_len = 0;
+          i += ELEM_BITS;
+          continue;
+        }
+
+      /* Turn the bits equal to VALUE into ones, ignoring bits
+         before START and past the end of the bitmap. */
+      bits = (value ? b->bits[i] : ~b->bits[i]) & used_mask (b, i);
+      if (i == elem_idx (start))
+        bits &= (elem_type) -1 << (start % ELEM_BITS);
+
+      if (bits == (elem_type) -1)
+        {
+          /* Whole element extends (or starts) the run. */
+          if (run_len == 0)
+            run_start = i * ELEM_BITS;
+          run_len += ELEM_BITS;
+          if (run_len >= cnt)
+            return run_start;
+          i++;
+          continue;
+        }
+
+      /* Walk the runs of ones inside a mixed element. */
+      pos = 0;
+      while (pos < ELEM_BITS)
+        {
+          elem_type rest = bits >> pos;
+          size_t zeros, ones;
+
+          if (rest == 0)
+            {
+              run_len = 0;
+              break;
+            }
+          zeros = __builtin_ctzl (rest);
+          if (zeros > 0)
+            {
+              run_len = 0;
+              pos += zeros;
+              rest >>= zeros;
+            }
+          if (run_len == 0)
+            run_start = i * ELEM_BITS + pos;
+          ones = ~rest == 0 ? ELEM_BITS - pos : (size_t) __builtin_ctzl (~rest);
+          run_len += ones;
+          if (run_len >= cnt)
+            return run_start;
+          pos += ones;
+        }
+      i++;
     }
   return BITMAP_ERROR;
 }
@@ -343,9 +526,13 @@ bitmap_read (struct bitmap *b, struct file *file)
   bool success = true;
   if (b->bit_cnt > 0) 
     {
+      size_t i;
+
       off_t size = byte_cnt (b->bit_cnt);
       success = file_read_at (file, b->bits, size, 0) == size;
       b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+      for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+        update_summary (b, i);
     }
   return success;
 }
@@ -358,6 +545,27 @@ bitmap_write (const struct bitmap *b, struct file *file)
   off_t size = byte_cnt (b->bit_cnt);
   return file_write_at (file, b->bits, size, 0) == size;
 }
+
+/* Writes to FILE only the part of B that holds the CNT bits
+   starting at START, which must be where bitmap_write() would
+   put it.  Return true if successful, false otherwise. */
+bool
+bitmap_write_range (const struct bitmap *b, struct file *file,
+                    size_t start, size_t cnt)
+{
+  size_t first, last;
+  off_t ofs, size;
+
+  ASSERT (start <= b->bit_cnt);
+  ASSERT (start + cnt <= b->bit_cnt);
+  if (cnt == 0)
+    return true;
+  first = elem_idx (start);
+  last = elem_idx (start + cnt - 1);
+  ofs = first * sizeof (elem_type);
+  size = (last - first + 1) * sizeof (elem_type);
+  return file_write_at (file, b->bits + first, size, ofs) == size;
+}
 #endif /* FILESYS */
 
 /* Debugging. */
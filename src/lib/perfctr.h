@@ -0,0 +1,55 @@
+#ifndef __LIB_PERFCTR_H
+#define __LIB_PERFCTR_H
+
+/* Kernel performance counters, shared between the kernel and
+   user programs that read them with perf_read(). */
+
+/* Each counter's name and description. */
+#define PERF_COUNTERS(X)                                                \
+  X (CACHE_HIT,       "buffer cache hits")                              \
+  X (CACHE_MISS,      "buffer cache misses")                            \
+  X (CACHE_EVICT,     "buffer cache evictions")                         \
+  X (CACHE_WRITEBACK, "buffer cache dirty writebacks")                  \
+  X (JOURNAL_COMMIT,  "journal commits")                                \
+  X (JOURNAL_WRITE,   "sectors written to the journal")                 \
+  X (PF_ZERO,         "zero-fill page faults")                          \
+  X (PF_SWAP,         "swap-in page faults")                            \
+  X (PF_MMAP,         "mmap page faults")                               \
+  X (PF_STACK,        "stack growth page faults")                       \
+  X (SWAP_OUT,        "pages swapped out")                              \
+  X (LOCK_CONTENDED,  "contended lock acquisitions")                    \
+  X (CONTEXT_SWITCH,  "context switches")                              \
+  X (TIMER_TICK,      "timer ticks")
+
+/* Counter numbers. */
+enum perf_counter
+  {
+#define PERF_ENUM(NAME, DESC) PERF_##NAME,
+    PERF_COUNTERS (PERF_ENUM)
+#undef PERF_ENUM
+    PERF_CNT                    /* Number of named counters. */
+  };
+
+/* Counter PERF_SYSCALL_BASE + N counts calls to system call N,
+   for N less than PERF_SYSCALL_CNT. */
+#define PERF_SYSCALL_BASE PERF_CNT
+#define PERF_SYSCALL_CNT 64
+
+/* Total number of counters. */
+#define PERF_TOTAL (PERF_SYSCALL_BASE + PERF_SYSCALL_CNT)
+
+/* Latency histograms, read with perf_hist().  Histogram
+   PERF_LAT_SYSCALL_BASE + N times system call N; histogram
+   PERF_LAT_FAULT_BASE + K times page faults counted by counter
+   PERF_PF_ZERO + K. */
+#define PERF_LAT_SYSCALL_BASE 0
+#define PERF_LAT_FAULT_BASE (PERF_LAT_SYSCALL_BASE + PERF_SYSCALL_CNT)
+#define PERF_LAT_FAULT_CNT (PERF_PF_STACK - PERF_PF_ZERO + 1)
+#define PERF_LAT_TOTAL (PERF_LAT_FAULT_BASE + PERF_LAT_FAULT_CNT)
+
+/* Bucket B of a histogram counts events that took from 2**B up
+   to 2**(B+1) CPU cycles; bucket 0 also counts 0 cycles and the
+   last bucket everything longer. */
+#define PERF_LAT_BUCKETS 32
+
+#endif /* lib/perfctr.h */
@@ -28,7 +28,24 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_READV,                  /* Read into a scatter list. */
+    SYS_WRITEV,                 /* Write from a gather list. */
+    SYS_PREAD,                  /* Read at a given file offset. */
+    SYS_PWRITE,                 /* Write at a given file offset. */
+    SYS_COPY_FILE_RANGE,        /* Copy between files in the kernel. */
+    SYS_RING_SETUP,             /* Register a batched syscall ring. */
+    SYS_RING_ENTER,             /* Run requests queued in the ring. */
+    SYS_AIO_READ,               /* Start an asynchronous read. */
+    SYS_AIO_WRITE,              /* Start an asynchronous write. */
+    SYS_AIO_POLL,               /* Check an asynchronous request. */
+    SYS_AIO_WAIT,               /* Wait for an asynchronous request. */
+    SYS_PERF_READ,              /* Read kernel performance counters. */
+    SYS_PERF_TRACK,             /* Keep latency histograms for us. */
+    SYS_PERF_HIST,              /* Read a latency histogram. */
+    SYS_TRACE                   /* Start or stop event tracing. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,66 @@
+#ifndef __LIB_SYSRING_H
+#define __LIB_SYSRING_H
+
+#include <stdint.h>
+
+/* Batched system call ring, shared between a user process and
+   the kernel.
+
+   The process registers one page holding a struct sys_ring with
+   ring_setup().  It queues requests by filling
+   sq[sq_tail % RING_SQ_ENTRIES] and incrementing sq_tail, then
+   calls ring_enter() once to have the kernel run them in order.
+   The kernel advances sq_head as it consumes requests and posts
+   one completion per request at cq[cq_tail % RING_CQ_ENTRIES],
+   which the process reaps by advancing cq_head.  The kernel stops
+   early when the completion queue is full. */
+
+/* Request opcodes.  Results match the corresponding system call;
+   RING_OP_SEEK completes with 0. */
+enum ring_op
+  {
+    RING_OP_NOP,                /* Does nothing, completes with 0. */
+    RING_OP_READ,               /* read (fd, buf, len). */
+    RING_OP_WRITE,              /* write (fd, buf, len). */
+    RING_OP_PREAD,              /* pread (fd, buf, len, off). */
+    RING_OP_PWRITE,             /* pwrite (fd, buf, len, off). */
+    RING_OP_SEEK,               /* seek (fd, off). */
+    RING_OP_TELL,               /* tell (fd). */
+    RING_OP_FILESIZE,           /* filesize (fd). */
+    RING_OP_OPEN,               /* open (buf). */
+    RING_OP_CLOSE               /* close (fd). */
+  };
+
+/* Submission queue entry. */
+struct ring_sqe
+  {
+    uint32_t op;                /* One of enum ring_op. */
+    int32_t fd;                 /* File descriptor. */
+    void *buf;                  /* Buffer, or file name for open. */
+    uint32_t len;               /* Buffer length in bytes. */
+    uint32_t off;               /* File offset. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* Completion queue entry. */
+struct ring_cqe
+  {
+    uint32_t user_data;         /* From the submission. */
+    int32_t res;                /* Result of the request. */
+  };
+
+#define RING_SQ_ENTRIES 64      /* Submission slots, power of 2. */
+#define RING_CQ_ENTRIES 128     /* Completion slots, power of 2. */
+
+/* The shared ring page. */
+struct sys_ring
+  {
+    volatile uint32_t sq_head;  /* Next request the kernel takes. */
+    volatile uint32_t sq_tail;  /* Next free submission slot. */
+    volatile uint32_t cq_head;  /* Next completion to reap. */
+    volatile uint32_t cq_tail;  /* Next completion slot to fill. */
+    struct ring_sqe sq[RING_SQ_ENTRIES];
+    struct ring_cqe cq[RING_CQ_ENTRIES];
+  };
+
+#endif /* lib/sysring.h */
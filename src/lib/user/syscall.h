@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <iovec.h>
+#include <sysring.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +47,21 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pread (int fd, void *buffer, unsigned size, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned size, unsigned offset);
+int copy_file_range (int fd_in, int fd_out, unsigned size);
+bool ring_setup (struct sys_ring *ring);
+int ring_enter (unsigned to_submit);
+int aio_read (int fd, void *buffer, unsigned size, unsigned offset);
+int aio_write (int fd, const void *buffer, unsigned size, unsigned offset);
+int aio_poll (int id);
+int aio_wait (int id);
+int perf_read (unsigned first, unsigned cnt, unsigned long long *values);
+bool perf_track (void);
+bool perf_hist (unsigned id, bool self, unsigned *buckets);
+bool trace (bool on);
+
 #endif /* lib/user/syscall.h */
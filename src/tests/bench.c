@@ -0,0 +1,103 @@
+/* Measurement and reporting for the benchmark programs.
+
+   A benchmark brackets each measurement with bench_begin() and
+   bench_end().  These read the kernel performance counters at
+   both ends, and bench_end() prints a single line:
+
+     (TEST) bench LABEL ticks=T ops=N ops/s=R bytes=B bytes/s=R ...
+
+   followed by how much each other counter moved, as
+   "cache_hit=...", "pf_swap=...", and so on.  The line is made of
+   space-separated key=value fields so that "make bench" output
+   can be parsed mechanically.
+
+   Time is counted in timer ticks, so a measurement should last
+   many ticks to be meaningful.  One that ends within the tick it
+   started in is charged a whole tick, making its rates upper
+   bounds. */
+
+#include "tests/bench.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "devices/timer.h"
+#include "tests/lib.h"
+
+static const char *names[PERF_CNT] =
+  {
+#define PERF_NAME(NAME, DESC) #NAME,
+    PERF_COUNTERS (PERF_NAME)
+#undef PERF_NAME
+  };
+
+static void read_counters (unsigned long long values[PERF_CNT]);
+
+/* Starts measuring B, described by printf-style LABEL, which
+   must not contain spaces. */
+void
+bench_begin (struct bench *b, const char *label, ...)
+{
+  va_list args;
+
+  va_start (args, label);
+  vsnprintf (b->label, sizeof b->label, label, args);
+  va_end (args);
+  read_counters (b->start);
+}
+
+/* Returns how far counter ID has moved since B began. */
+unsigned long long
+bench_delta (const struct bench *b, enum perf_counter id)
+{
+  unsigned long long now[PERF_CNT];
+
+  read_counters (now);
+  return now[id] - b->start[id];
+}
+
+/* Finishes measuring B, which did OPS operations that moved
+   BYTES bytes in all, and reports the results. */
+void
+bench_end (struct bench *b, unsigned long long ops,
+           unsigned long long bytes)
+{
+  unsigned long long now[PERF_CNT];
+  unsigned long long ticks;
+  char line[512];
+  size_t len;
+  int i;
+
+  read_counters (now);
+  ticks = now[PERF_TIMER_TICK] - b->start[PERF_TIMER_TICK];
+
+  len = snprintf (line, sizeof line, "bench %s ticks=%llu ops=%llu ops/s=%llu",
+                  b->label, ticks, ops,
+                  ops * TIMER_FREQ / (ticks > 0 ? ticks : 1));
+  if (bytes > 0 && len < sizeof line)
+    len += snprintf (line + len, sizeof line - len,
+                     " bytes=%llu bytes/s=%llu",
+                     bytes, bytes * TIMER_FREQ / (ticks > 0 ? ticks : 1));
+  for (i = 0; i < PERF_CNT; i++)
+    if (i != PERF_TIMER_TICK && len < sizeof line)
+      {
+        const char *p;
+
+        len += snprintf (line + len, sizeof line - len, " ");
+        for (p = names[i]; *p != '\0' && len < sizeof line - 1; p++)
+          line[len++] = tolower (*p);
+        line[len] = '\0';
+        len += snprintf (line + len, sizeof line - len, "=%llu",
+                         now[i] - b->start[i]);
+      }
+  msg ("%s", line);
+}
+
+/* Reads the named kernel performance counters into VALUES. */
+static void
+read_counters (unsigned long long values[PERF_CNT])
+{
+  if (perf_read (0, PERF_CNT, values) != PERF_CNT)
+    fail ("perf_read failed");
+}
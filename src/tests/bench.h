@@ -0,0 +1,20 @@
+#ifndef TESTS_BENCH_H
+#define TESTS_BENCH_H
+
+#include <debug.h>
+#include <perfctr.h>
+
+/* A measurement in progress. */
+struct bench
+  {
+    char label[64];                     /* What is being measured. */
+    unsigned long long start[PERF_CNT]; /* Counters when it began. */
+  };
+
+void bench_begin (struct bench *, const char *label, ...)
+     PRINTF_FORMAT (2, 3);
+unsigned long long bench_delta (const struct bench *, enum perf_counter);
+void bench_end (struct bench *, unsigned long long ops,
+                unsigned long long bytes);
+
+#endif /* tests/bench.h */
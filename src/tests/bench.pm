@@ -0,0 +1,31 @@
+use strict;
+use warnings;
+use tests::tests;
+
+# check_bench ()
+#
+# Checks that a benchmark ran to completion.  Its output must be
+# "begin", at least one "bench" line of key=value fields as printed
+# by tests/bench.c or tests/threads/bench/bench.c, and "end".
+# Process exit codes may appear anywhere.  The measurements themselves are
+# not judged; "make bench" collects them.
+sub check_bench {
+    our ($test);
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+    @output = grep (!/^[a-zA-Z0-9-_]+: exit\(\-?\d+\)$/, @output);
+
+    my ($name) = $test =~ m%([^/]+)$%;
+    fail "Run didn't begin with \"($name) begin\"\n"
+      if !@output || shift (@output) ne "($name) begin";
+    fail "Run didn't end with \"($name) end\"\n"
+      if !@output || pop (@output) ne "($name) end";
+    fail "Run didn't report any measurements\n" if !@output;
+    for my $line (@output) {
+	fail "Malformed measurement: $line\n"
+	  if $line !~ /^\(\Q$name\E\) bench \S+( [a-z_\/]+=\d+)+$/;
+    }
+}
+
+1;
@@ -0,0 +1,52 @@
+/* Copies a file spanning several sectors with copy_file_range(),
+   starting partway into a sector, and checks the copy, the file
+   positions, and that the running executable cannot be copied
+   onto. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define TEST_SIZE 5000
+#define SKIP 100
+#define FIRST 1234
+
+static char buf[TEST_SIZE];
+
+void
+test_main (void) 
+{
+  int src, dst, exe;
+
+  random_init (0);
+  random_bytes (buf, sizeof buf);
+
+  CHECK (create ("src", 0), "create \"src\"");
+  CHECK ((src = open ("src")) > 1, "open \"src\"");
+  CHECK (write (src, buf, sizeof buf) == TEST_SIZE, "write \"src\"");
+  CHECK (create ("dst", 0), "create \"dst\"");
+  CHECK ((dst = open ("dst")) > 1, "open \"dst\"");
+
+  msg ("seek \"src\" to %d", SKIP);
+  seek (src, SKIP);
+  CHECK (copy_file_range (src, dst, FIRST) == FIRST,
+         "copy %d bytes from \"src\" to \"dst\"", FIRST);
+  CHECK (tell (src) == SKIP + FIRST && tell (dst) == FIRST,
+         "tell after first copy");
+  CHECK (copy_file_range (src, dst, TEST_SIZE) == TEST_SIZE - SKIP - FIRST,
+         "copy rest of \"src\" to \"dst\"");
+  CHECK (tell (src) == TEST_SIZE && tell (dst) == TEST_SIZE - SKIP,
+         "tell after second copy");
+  CHECK (copy_file_range (src, dst, TEST_SIZE) == 0,
+         "copy at end of \"src\"");
+  msg ("close \"dst\"");
+  close (dst);
+  check_file ("dst", buf + SKIP, TEST_SIZE - SKIP);
+
+  CHECK ((exe = open ("copy-range")) > 1, "open \"copy-range\"");
+  seek (src, 0);
+  CHECK (copy_file_range (src, exe, TEST_SIZE) == -1,
+         "try to copy onto \"copy-range\"");
+  CHECK (tell (src) == 0 && tell (exe) == 0, "tell after failed copy");
+}
@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(copy-range) begin
+(copy-range) create "src"
+(copy-range) open "src"
+(copy-range) write "src"
+(copy-range) create "dst"
+(copy-range) open "dst"
+(copy-range) seek "src" to 100
+(copy-range) copy 1234 bytes from "src" to "dst"
+(copy-range) tell after first copy
+(copy-range) copy rest of "src" to "dst"
+(copy-range) tell after second copy
+(copy-range) copy at end of "src"
+(copy-range) close "dst"
+(copy-range) open "dst" for verification
+(copy-range) verified contents of "dst"
+(copy-range) close "dst"
+(copy-range) open "copy-range"
+(copy-range) try to copy onto "copy-range"
+(copy-range) tell after failed copy
+(copy-range) end
+EOF
+pass;
@@ -0,0 +1,70 @@
+/* Runs CHILD_CNT processes at once that all read one shared file,
+   then CHILD_CNT that each write a file of their own, then half
+   of each, and reports the combined throughput of each mix. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/bench.h"
+#include "tests/filesys/bench/bench-rw.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[CHUNK_SIZE];
+
+static void run_mix (const char *label, int reader_cnt);
+
+void
+test_main (void) 
+{
+  size_t ofs;
+  int fd;
+
+  if (!create (shared_name, 0) || (fd = open (shared_name)) < 2)
+    fail ("create and open \"%s\" failed", shared_name);
+  for (ofs = 0; ofs < SHARED_SIZE; ofs += CHUNK_SIZE)
+    if (write (fd, buf, CHUNK_SIZE) != CHUNK_SIZE)
+      fail ("write at offset %zu in \"%s\" failed", ofs, shared_name);
+  close (fd);
+
+  run_mix ("readers", CHILD_CNT);
+  run_mix ("writers", 0);
+  run_mix ("mixed", CHILD_CNT / 2);
+}
+
+/* Runs READER_CNT readers and CHILD_CNT - READER_CNT writers
+   together and reports them as LABEL.  Writers remove their
+   files afterward, so that each mix starts from the same state. */
+static void
+run_mix (const char *label, int reader_cnt) 
+{
+  pid_t pids[CHILD_CNT];
+  unsigned long long bytes;
+  struct bench b;
+  int i;
+
+  bench_begin (&b, "%s-%d", label, CHILD_CNT);
+  for (i = 0; i < CHILD_CNT; i++) 
+    {
+      char cmd_line[32];
+
+      snprintf (cmd_line, sizeof cmd_line, "child-bench-rw %c %d",
+                i < reader_cnt ? 'r' : 'w', i);
+      if ((pids[i] = exec (cmd_line)) == PID_ERROR)
+        fail ("exec \"%s\" failed", cmd_line);
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (pids[i]) != i)
+      fail ("child %d failed", i);
+  bytes = ((unsigned long long) reader_cnt * SHARED_SIZE
+           + (unsigned long long) (CHILD_CNT - reader_cnt) * PRIVATE_SIZE);
+  bench_end (&b, bytes / CHUNK_SIZE, bytes);
+
+  for (i = reader_cnt; i < CHILD_CNT; i++) 
+    {
+      char file_name[32];
+
+      snprintf (file_name, sizeof file_name, "private%d", i);
+      if (!remove (file_name))
+        fail ("remove \"%s\" failed", file_name);
+    }
+}
@@ -0,0 +1,49 @@
+/* Creates many small files in one directory, then deletes them
+   all, and reports the rate of each. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 128
+#define FILE_SIZE 512
+
+static char buf[FILE_SIZE];
+
+void
+test_main (void) 
+{
+  char file_name[16];
+  struct bench b;
+  int i;
+
+  if (!mkdir ("storm") || !chdir ("storm"))
+    fail ("mkdir and chdir \"storm\" failed");
+
+  bench_begin (&b, "create");
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      int fd;
+
+      snprintf (file_name, sizeof file_name, "f%d", i);
+      if (!create (file_name, 0))
+        fail ("create \"%s\" failed", file_name);
+      if ((fd = open (file_name)) < 2)
+        fail ("open \"%s\" failed", file_name);
+      if (write (fd, buf, sizeof buf) != (int) sizeof buf)
+        fail ("write \"%s\" failed", file_name);
+      close (fd);
+    }
+  bench_end (&b, FILE_CNT, (unsigned long long) FILE_CNT * FILE_SIZE);
+
+  bench_begin (&b, "remove");
+  for (i = 0; i < FILE_CNT; i++) 
+    {
+      snprintf (file_name, sizeof file_name, "f%d", i);
+      if (!remove (file_name))
+        fail ("remove \"%s\" failed", file_name);
+    }
+  bench_end (&b, FILE_CNT, 0);
+}
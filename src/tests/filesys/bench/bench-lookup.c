@@ -0,0 +1,70 @@
+/* Times opening a file at the bottom of a deep directory chain
+   and opening random files in a large directory. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DEPTH 16
+#define DIR_FILE_CNT 256
+#define OPEN_CNT 512
+
+static void open_close (const char *file_name);
+
+void
+test_main (void) 
+{
+  char path[64];
+  struct bench b;
+  int i;
+
+  /* Deep path: /d/d/.../d/f. */
+  path[0] = '\0';
+  for (i = 0; i < DEPTH; i++) 
+    {
+      strlcat (path, "/d", sizeof path);
+      if (!mkdir (path))
+        fail ("mkdir \"%s\" failed", path);
+    }
+  strlcat (path, "/f", sizeof path);
+  if (!create (path, 0))
+    fail ("create \"%s\" failed", path);
+
+  bench_begin (&b, "deep-open-%d", DEPTH);
+  for (i = 0; i < OPEN_CNT; i++)
+    open_close (path);
+  bench_end (&b, OPEN_CNT, 0);
+
+  /* Large directory. */
+  if (!mkdir ("big"))
+    fail ("mkdir \"big\" failed");
+  for (i = 0; i < DIR_FILE_CNT; i++) 
+    {
+      snprintf (path, sizeof path, "big/file%d", i);
+      if (!create (path, 0))
+        fail ("create \"%s\" failed", path);
+    }
+
+  bench_begin (&b, "dir-lookup-%d", DIR_FILE_CNT);
+  for (i = 0; i < OPEN_CNT; i++) 
+    {
+      snprintf (path, sizeof path, "big/file%lu",
+                random_ulong () % DIR_FILE_CNT);
+      open_close (path);
+    }
+  bench_end (&b, OPEN_CNT, 0);
+}
+
+/* Opens and closes FILE_NAME. */
+static void
+open_close (const char *file_name) 
+{
+  int fd = open (file_name);
+  if (fd < 2)
+    fail ("open \"%s\" failed", file_name);
+  close (fd);
+}
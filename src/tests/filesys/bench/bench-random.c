@@ -0,0 +1,67 @@
+/* Reads and writes blocks at random offsets within a large file,
+   for each of several request sizes, and reports the throughput
+   of every pass. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (512 * 1024)
+#define OP_CNT 512
+
+static char buf[8192];
+static const size_t sizes[] = {512, 4096, 8192};
+
+static size_t random_offset (size_t size);
+
+void
+test_main (void) 
+{
+  static const char file_name[] = "random";
+  size_t i, ofs;
+  int fd;
+
+  if (!create (file_name, FILE_SIZE))
+    fail ("create \"%s\" failed", file_name);
+  if ((fd = open (file_name)) < 2)
+    fail ("open \"%s\" failed", file_name);
+  for (ofs = 0; ofs < FILE_SIZE; ofs += sizeof buf)
+    if (write (fd, buf, sizeof buf) != (int) sizeof buf)
+      fail ("write %zu bytes at offset %zu failed", sizeof buf, ofs);
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      size_t size = sizes[i];
+      struct bench b;
+      int op;
+
+      bench_begin (&b, "random-write-%zu", size);
+      for (op = 0; op < OP_CNT; op++)
+        {
+          ofs = random_offset (size);
+          if (pwrite (fd, buf, size, ofs) != (int) size)
+            fail ("write %zu bytes at offset %zu failed", size, ofs);
+        }
+      bench_end (&b, OP_CNT, (unsigned long long) OP_CNT * size);
+
+      bench_begin (&b, "random-read-%zu", size);
+      for (op = 0; op < OP_CNT; op++)
+        {
+          ofs = random_offset (size);
+          if (pread (fd, buf, size, ofs) != (int) size)
+            fail ("read %zu bytes at offset %zu failed", size, ofs);
+        }
+      bench_end (&b, OP_CNT, (unsigned long long) OP_CNT * size);
+    }
+  close (fd);
+}
+
+/* Returns a random SIZE-aligned offset of a SIZE-byte block
+   within the file. */
+static size_t
+random_offset (size_t size) 
+{
+  return random_ulong () % (FILE_SIZE / size) * size;
+}
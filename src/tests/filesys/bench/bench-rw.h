@@ -0,0 +1,11 @@
+#ifndef TESTS_FILESYS_BENCH_BENCH_RW_H
+#define TESTS_FILESYS_BENCH_BENCH_RW_H
+
+/* Shared by bench-concurrent and its child-bench-rw processes. */
+#define CHILD_CNT 4
+#define CHUNK_SIZE 4096
+#define SHARED_SIZE (256 * 1024)        /* Read by each reader. */
+#define PRIVATE_SIZE (128 * 1024)       /* Written by each writer. */
+static const char shared_name[] = "shared";
+
+#endif /* tests/filesys/bench/bench-rw.h */
@@ -0,0 +1,54 @@
+/* Writes a large file sequentially and then reads it back, once
+   for each of several request sizes, and reports the throughput
+   of every pass. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/bench.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (512 * 1024)
+
+static char buf[16384];
+static const size_t sizes[] = {64, 512, 4096, 16384};
+
+void
+test_main (void) 
+{
+  size_t i;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      size_t size = sizes[i];
+      char file_name[16];
+      struct bench b;
+      size_t ofs;
+      int fd;
+
+      snprintf (file_name, sizeof file_name, "seq-%zu", size);
+      if (!create (file_name, 0))
+        fail ("create \"%s\" failed", file_name);
+
+      if ((fd = open (file_name)) < 2)
+        fail ("open \"%s\" failed", file_name);
+      bench_begin (&b, "seq-write-%zu", size);
+      for (ofs = 0; ofs < FILE_SIZE; ofs += size)
+        if (write (fd, buf, size) != (int) size)
+          fail ("write %zu bytes at offset %zu failed", size, ofs);
+      bench_end (&b, FILE_SIZE / size, FILE_SIZE);
+      close (fd);
+
+      if ((fd = open (file_name)) < 2)
+        fail ("reopen \"%s\" failed", file_name);
+      bench_begin (&b, "seq-read-%zu", size);
+      for (ofs = 0; ofs < FILE_SIZE; ofs += size)
+        if (read (fd, buf, size) != (int) size)
+          fail ("read %zu bytes at offset %zu failed", size, ofs);
+      bench_end (&b, FILE_SIZE / size, FILE_SIZE);
+      close (fd);
+
+      if (!remove (file_name))
+        fail ("remove \"%s\" failed", file_name);
+    }
+}
@@ -0,0 +1,46 @@
+/* Child process for bench-concurrent.
+   Invoked as "child-bench-rw r IDX" to read the whole shared
+   file, or as "child-bench-rw w IDX" to write a file of its own,
+   in CHUNK_SIZE requests either way.  Exits with IDX. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/filesys/bench/bench-rw.h"
+#include "tests/lib.h"
+
+const char *test_name = "child-bench-rw";
+
+static char buf[CHUNK_SIZE];
+
+int
+main (int argc, const char *argv[]) 
+{
+  char file_name[16];
+  size_t ofs;
+  int fd;
+
+  if (argc != 3)
+    fail ("argc must be 3, actually %d", argc);
+
+  if (argv[1][0] == 'r') 
+    {
+      if ((fd = open (shared_name)) < 2)
+        fail ("open \"%s\" failed", shared_name);
+      for (ofs = 0; ofs < SHARED_SIZE; ofs += CHUNK_SIZE)
+        if (read (fd, buf, CHUNK_SIZE) != CHUNK_SIZE)
+          fail ("read at offset %zu in \"%s\" failed", ofs, shared_name);
+    }
+  else 
+    {
+      snprintf (file_name, sizeof file_name, "private%s", argv[2]);
+      if (!create (file_name, 0) || (fd = open (file_name)) < 2)
+        fail ("create and open \"%s\" failed", file_name);
+      for (ofs = 0; ofs < PRIVATE_SIZE; ofs += CHUNK_SIZE)
+        if (write (fd, buf, CHUNK_SIZE) != CHUNK_SIZE)
+          fail ("write at offset %zu in \"%s\" failed", ofs, file_name);
+    }
+  close (fd);
+
+  return atoi (argv[2]);
+}
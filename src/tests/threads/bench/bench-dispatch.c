@@ -0,0 +1,74 @@
+/* Measures dispatch cost as the ready list grows.  Two threads
+   yield to each other while a growing number of lower-priority
+   threads wait on the ready list, which the scheduler must look
+   through on every switch. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench/bench.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define YIELD_CNT 2000
+
+static thread_func yielder;
+static thread_func filler;
+
+static struct semaphore done, gone;
+
+static const int ready_cnts[] = {0, 32, 128, 512};
+
+void
+test_bench_dispatch (void) 
+{
+  size_t r;
+
+  ASSERT (!thread_mlfqs);
+  sema_init (&done, 0);
+  sema_init (&gone, 0);
+
+  for (r = 0; r < sizeof ready_cnts / sizeof *ready_cnts; r++) 
+    {
+      int ready_cnt = ready_cnts[r];
+      struct bench b;
+      char extra[32];
+      int i;
+
+      /* Fillers sit on the ready list below the main thread;
+         yielders run above it. */
+      thread_set_priority (PRI_MAX);
+      for (i = 0; i < ready_cnt; i++)
+        if (thread_create ("filler", PRI_DEFAULT - 1, filler, NULL)
+            == TID_ERROR)
+          fail ("out of memory creating filler %d", i);
+      thread_create ("yielder 0", PRI_DEFAULT + 1, yielder, NULL);
+      thread_create ("yielder 1", PRI_DEFAULT + 1, yielder, NULL);
+
+      bench_begin (&b, "dispatch-ready-%d", ready_cnt);
+      thread_set_priority (PRI_DEFAULT);
+      sema_down (&done);
+      sema_down (&done);
+      snprintf (extra, sizeof extra, " ready=%d", ready_cnt);
+      bench_end (&b, 2 * YIELD_CNT, extra);
+
+      /* Blocking lets the fillers run and exit. */
+      for (i = 0; i < ready_cnt; i++)
+        sema_down (&gone);
+    }
+}
+
+static void
+yielder (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < YIELD_CNT; i++)
+    thread_yield ();
+  sema_up (&done);
+}
+
+static void
+filler (void *aux UNUSED) 
+{
+  sema_up (&gone);
+}
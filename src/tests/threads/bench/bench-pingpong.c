@@ -0,0 +1,66 @@
+/* Measures lock ping-pong: two threads take turns under one lock,
+   each waiting on a condition variable for its turn and then
+   handing the turn to the other.  Every handoff wakes the other
+   thread while the lock is still held, so it also measures
+   contended acquisition. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench/bench.h"
+#include "threads/perf.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define HANDOFF_CNT 5000
+
+static thread_func player;
+
+static struct lock lock;
+static struct condition turn_changed;
+static int turn;                        /* Index of the player to go. */
+static struct semaphore done;
+
+void
+test_bench_pingpong (void) 
+{
+  static int players[2] = {0, 1};
+  uint64_t contended;
+  struct bench b;
+  char extra[48];
+
+  ASSERT (!thread_mlfqs);
+  lock_init (&lock);
+  cond_init (&turn_changed);
+  sema_init (&done, 0);
+  turn = 0;
+
+  thread_set_priority (PRI_MAX);
+  thread_create ("player 0", PRI_DEFAULT + 1, player, &players[0]);
+  thread_create ("player 1", PRI_DEFAULT + 1, player, &players[1]);
+  contended = perf_get (PERF_LOCK_CONTENDED);
+  bench_begin (&b, "lock-pingpong");
+  thread_set_priority (PRI_DEFAULT);
+  sema_down (&done);
+  sema_down (&done);
+  snprintf (extra, sizeof extra, " lock_contended=%llu",
+            perf_get (PERF_LOCK_CONTENDED) - contended);
+  bench_end (&b, 2 * HANDOFF_CNT, extra);
+}
+
+static void
+player (void *me_) 
+{
+  int me = *(int *) me_;
+  int i;
+
+  for (i = 0; i < HANDOFF_CNT; i++) 
+    {
+      lock_acquire (&lock);
+      while (turn != me)
+        cond_wait (&turn_changed, &lock);
+      turn = !me;
+      cond_signal (&turn_changed, &lock);
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
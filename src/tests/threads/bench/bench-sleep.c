@@ -0,0 +1,84 @@
+/* Measures timer_sleep() accuracy with thousands of sleepers.
+   Each sleeper wakes at a tick spread over a window a little in
+   the future and records how many ticks late it woke.  The total
+   ticks taken also show what many sleepers cost every timer
+   interrupt. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench/bench.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define SLEEPER_CNT 2000
+#define SLACK_TICKS 20                  /* Before the first wakeup. */
+#define SPREAD_TICKS 100                /* Wakeups are spread over. */
+
+static thread_func sleeper;
+
+static struct semaphore go, done;
+static int64_t start;
+static int64_t late_max, late_sum;
+static int on_time_cnt;
+static int wakeup_ticks[SLEEPER_CNT];
+
+void
+test_bench_sleep (void) 
+{
+  struct bench b;
+  char extra[96];
+  int i;
+
+  ASSERT (!thread_mlfqs);
+  sema_init (&go, 0);
+  sema_init (&done, 0);
+
+  /* Each sleeper blocks on GO as soon as it is created. */
+  for (i = 0; i < SLEEPER_CNT; i++) 
+    {
+      char name[16];
+
+      wakeup_ticks[i] = SLACK_TICKS + i % SPREAD_TICKS;
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, &wakeup_ticks[i])
+          == TID_ERROR)
+        fail ("out of memory creating sleeper %d", i);
+    }
+
+  bench_begin (&b, "sleep-%d", SLEEPER_CNT);
+  start = timer_ticks ();
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_up (&go);
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_down (&done);
+  snprintf (extra, sizeof extra, " on_time=%d late_max=%lld late_total=%lld",
+            on_time_cnt, late_max, late_sum);
+  bench_end (&b, SLEEPER_CNT, extra);
+}
+
+/* Sleeps until *WAKEUP_ tick after the start and records how
+   late it woke. */
+static void
+sleeper (void *wakeup_) 
+{
+  int64_t wakeup, late;
+  enum intr_level old_level;
+
+  sema_down (&go);
+  wakeup = start + *(int *) wakeup_;
+  timer_sleep (wakeup - timer_ticks ());
+  late = timer_ticks () - wakeup;
+
+  old_level = intr_disable ();
+  if (late <= 0)
+    on_time_cnt++;
+  else
+    late_sum += late;
+  if (late > late_max)
+    late_max = late;
+  intr_set_level (old_level);
+
+  sema_up (&done);
+}
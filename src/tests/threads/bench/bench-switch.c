@@ -0,0 +1,85 @@
+/* Measures the context switch rate two ways: two threads at the
+   same priority yielding to each other, and two threads handing
+   control back and forth with a pair of semaphores, so that every
+   switch goes through blocking and unblocking. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench/bench.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUND_CNT 10000
+
+static thread_func yielder;
+static thread_func pinger;
+static thread_func ponger;
+
+static struct semaphore ping, pong, done;
+
+void
+test_bench_switch (void) 
+{
+  struct bench b;
+
+  ASSERT (!thread_mlfqs);
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  sema_init (&done, 0);
+
+  /* Create both threads before letting either run, so that they
+     run together from the start. */
+  thread_set_priority (PRI_MAX);
+  thread_create ("yielder 0", PRI_DEFAULT + 1, yielder, NULL);
+  thread_create ("yielder 1", PRI_DEFAULT + 1, yielder, NULL);
+  bench_begin (&b, "yield-pair");
+  thread_set_priority (PRI_DEFAULT);
+  sema_down (&done);
+  sema_down (&done);
+  bench_end (&b, 2 * ROUND_CNT, "");
+
+  thread_set_priority (PRI_MAX);
+  thread_create ("pinger", PRI_DEFAULT + 1, pinger, NULL);
+  thread_create ("ponger", PRI_DEFAULT + 1, ponger, NULL);
+  bench_begin (&b, "sema-pair");
+  thread_set_priority (PRI_DEFAULT);
+  sema_down (&done);
+  sema_down (&done);
+  bench_end (&b, 2 * ROUND_CNT, "");
+}
+
+static void
+yielder (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    thread_yield ();
+  sema_up (&done);
+}
+
+static void
+pinger (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  sema_up (&done);
+}
+
+static void
+ponger (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,76 @@
+/* Measures wakeup latency, the time from sema_up() until the
+   thread it wakes is running, in time-stamp counter cycles.  The
+   wakee runs at a higher priority than the waker and then at the
+   same priority; either way it should preempt the waker at once. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "tests/threads/bench/bench.h"
+#include "threads/perf.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAKE_CNT 10000
+
+static thread_func wakee;
+static void measure (const char *label, int priority);
+
+static struct semaphore wake, done;
+static uint64_t up_tsc;                 /* When the waker called sema_up(). */
+static uint64_t lat_min, lat_max, lat_sum;
+
+void
+test_bench_wakeup (void) 
+{
+  ASSERT (!thread_mlfqs);
+  measure ("wakeup-higher", PRI_DEFAULT + 1);
+  measure ("wakeup-equal", PRI_DEFAULT);
+}
+
+/* Wakes a thread at PRIORITY WAKE_CNT times and reports the
+   latency as LABEL. */
+static void
+measure (const char *label, int priority) 
+{
+  struct bench b;
+  char extra[96];
+  int i;
+
+  sema_init (&wake, 0);
+  sema_init (&done, 0);
+  lat_min = UINT64_MAX;
+  lat_max = lat_sum = 0;
+  thread_create ("wakee", priority, wakee, NULL);
+
+  bench_begin (&b, "%s", label);
+  for (i = 0; i < WAKE_CNT; i++) 
+    {
+      up_tsc = rdtsc ();
+      sema_up (&wake);
+    }
+  sema_down (&done);
+  snprintf (extra, sizeof extra, " lat_min=%llu lat_avg=%llu lat_max=%llu",
+            lat_min, lat_sum / WAKE_CNT, lat_max);
+  bench_end (&b, WAKE_CNT, extra);
+}
+
+/* Waits to be woken WAKE_CNT times, timing each wakeup. */
+static void
+wakee (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < WAKE_CNT; i++) 
+    {
+      uint64_t latency;
+
+      sema_down (&wake);
+      latency = rdtsc () - up_tsc;
+      if (latency < lat_min)
+        lat_min = latency;
+      if (latency > lat_max)
+        lat_max = latency;
+      lat_sum += latency;
+    }
+  sema_up (&done);
+}
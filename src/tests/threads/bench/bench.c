@@ -0,0 +1,50 @@
+/* Measurement and reporting for the scheduler benchmarks.
+
+   bench_end() prints one line in the same form as the user-mode
+   benchmarks in tests/bench.c:
+
+     (TEST) bench LABEL ticks=T ops=N ops/s=R cycles=C cycles/op=X
+       context_switch=S ...
+
+   (all on one line), where cycles come from the time-stamp
+   counter and the caller may append more key=value fields.  Time
+   in ticks is charged at least one tick, so rates of very short
+   measurements are upper bounds. */
+
+#include "tests/threads/bench/bench.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+#include "threads/perf.h"
+
+/* Starts measuring B, described by printf-style LABEL, which
+   must not contain spaces. */
+void
+bench_begin (struct bench *b, const char *label, ...) 
+{
+  va_list args;
+
+  va_start (args, label);
+  vsnprintf (b->label, sizeof b->label, label, args);
+  va_end (args);
+  b->start_switches = perf_get (PERF_CONTEXT_SWITCH);
+  b->start_ticks = timer_ticks ();
+  b->start_tsc = rdtsc ();
+}
+
+/* Finishes measuring B, which did OPS operations, and reports
+   the results followed by EXTRA, which is empty or a string of
+   " key=value" fields. */
+void
+bench_end (struct bench *b, unsigned long long ops, const char *extra) 
+{
+  uint64_t cycles = rdtsc () - b->start_tsc;
+  int64_t ticks = timer_elapsed (b->start_ticks);
+  uint64_t switches = perf_get (PERF_CONTEXT_SWITCH) - b->start_switches;
+
+  msg ("bench %s ticks=%lld ops=%llu ops/s=%llu cycles=%llu cycles/op=%llu "
+       "context_switch=%llu%s",
+       b->label, ticks, ops, ops * TIMER_FREQ / (ticks > 0 ? ticks : 1),
+       cycles, ops > 0 ? cycles / ops : 0, switches, extra);
+}
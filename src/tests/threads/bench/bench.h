@@ -0,0 +1,20 @@
+#ifndef TESTS_THREADS_BENCH_BENCH_H
+#define TESTS_THREADS_BENCH_BENCH_H
+
+#include <debug.h>
+#include <stdint.h>
+
+/* A measurement in progress. */
+struct bench
+  {
+    char label[64];             /* What is being measured. */
+    int64_t start_ticks;        /* Timer ticks when it began. */
+    uint64_t start_tsc;         /* Time-stamp counter when it began. */
+    uint64_t start_switches;    /* Context switches when it began. */
+  };
+
+void bench_begin (struct bench *, const char *label, ...)
+     PRINTF_FORMAT (2, 3);
+void bench_end (struct bench *, unsigned long long ops, const char *extra);
+
+#endif /* tests/threads/bench/bench.h */
@@ -38,6 +38,11 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"bench-switch", test_bench_switch},
+    {"bench-wakeup", test_bench_wakeup},
+    {"bench-pingpong", test_bench_pingpong},
+    {"bench-sleep", test_bench_sleep},
+    {"bench-dispatch", test_bench_dispatch},
   };
 
 static const char *test_name;
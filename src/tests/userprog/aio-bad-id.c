@@ -0,0 +1,23 @@
+/* Passes request ids that were never issued, or were already
+   reaped, to aio_poll() and aio_wait(), which must return -1. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[16];
+  int handle, id;
+
+  CHECK (aio_poll (12345) == -1, "aio_poll for unknown id");
+  CHECK (aio_wait (12345) == -1, "aio_wait for unknown id");
+  CHECK (aio_poll (-1) == -1, "aio_poll for negative id");
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((id = aio_read (handle, buf, sizeof buf, 0)) >= 0, "aio_read");
+  CHECK (aio_wait (id) == (int) sizeof buf, "aio_wait");
+  CHECK (aio_poll (id) == -1, "aio_poll for reaped id");
+  CHECK (aio_wait (id) == -1, "aio_wait for reaped id");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-bad-id) begin
+(aio-bad-id) aio_poll for unknown id
+(aio-bad-id) aio_wait for unknown id
+(aio-bad-id) aio_poll for negative id
+(aio-bad-id) open "sample.txt"
+(aio-bad-id) aio_read
+(aio-bad-id) aio_wait
+(aio-bad-id) aio_poll for reaped id
+(aio-bad-id) aio_wait for reaped id
+(aio-bad-id) end
+aio-bad-id: exit(0)
+EOF
+pass;
@@ -0,0 +1,15 @@
+/* Runs a child that exits with asynchronous writes still
+   outstanding, then checks that they all reached the file. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  CHECK (create ("aio", sizeof sample - 1), "create \"aio\"");
+  msg ("wait(exec()) = %d", wait (exec ("child-aio")));
+  check_file ("aio", sample, sizeof sample - 1);
+}
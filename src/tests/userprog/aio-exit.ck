@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-exit) begin
+(aio-exit) create "aio"
+(child-aio) begin
+(child-aio) open "aio"
+(child-aio) end
+child-aio: exit(0)
+(aio-exit) wait(exec()) = 0
+(aio-exit) open "aio" for verification
+(aio-exit) verified contents of "aio"
+(aio-exit) close "aio"
+(aio-exit) end
+aio-exit: exit(0)
+EOF
+pass;
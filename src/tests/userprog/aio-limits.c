@@ -0,0 +1,54 @@
+/* Checks that aio_read() rejects a request longer than the
+   maximum, more outstanding requests than a process may have,
+   and requests that would pin too much memory. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Limits from userprog/aio.h. */
+#define AIO_MAX_LEN (64 * 1024)
+#define AIO_MAX_REQUESTS 32
+
+static char buf[AIO_MAX_LEN + 1];
+
+/* Waits for the CNT requests in IDS. */
+static void
+wait_all (int ids[], int cnt) 
+{
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    if (aio_wait (ids[i]) < 0)
+      fail ("aio_wait for request %d failed", i);
+}
+
+void
+test_main (void) 
+{
+  int ids[AIO_MAX_REQUESTS];
+  int handle;
+  int cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (aio_read (handle, buf, AIO_MAX_LEN + 1, 0) == -1,
+         "aio_read longer than AIO_MAX_LEN");
+
+  for (cnt = 0; cnt < AIO_MAX_REQUESTS; cnt++)
+    if ((ids[cnt] = aio_read (handle, buf, 1, 0)) < 0)
+      fail ("aio_read %d of %d failed", cnt + 1, AIO_MAX_REQUESTS);
+  CHECK (aio_read (handle, buf, 1, 0) == -1,
+         "aio_read beyond AIO_MAX_REQUESTS");
+  wait_all (ids, cnt);
+
+  /* Each request pins the same 17 pages again, so the pin cap
+     turns one away long before the request limit. */
+  for (cnt = 0; cnt < AIO_MAX_REQUESTS; cnt++)
+    if ((ids[cnt] = aio_read (handle, buf, AIO_MAX_LEN, 0)) < 0)
+      break;
+  CHECK (cnt > 0 && cnt < AIO_MAX_REQUESTS, "pin cap rejects a request");
+  wait_all (ids, cnt);
+  CHECK ((ids[0] = aio_read (handle, buf, AIO_MAX_LEN, 0)) >= 0,
+         "aio_read after reaping");
+  wait_all (ids, 1);
+}
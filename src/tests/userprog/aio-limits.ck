@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-limits) begin
+(aio-limits) open "sample.txt"
+(aio-limits) aio_read longer than AIO_MAX_LEN
+(aio-limits) aio_read beyond AIO_MAX_REQUESTS
+(aio-limits) pin cap rejects a request
+(aio-limits) aio_read after reaping
+(aio-limits) end
+aio-limits: exit(0)
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* Keeps several asynchronous writes and then several
+   asynchronous reads in flight at once, and checks their
+   results with aio_wait(). */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define REQ_CNT 4
+#define REQ_SIZE 1000
+
+static char data[REQ_CNT * REQ_SIZE];
+static char buf[REQ_CNT * REQ_SIZE];
+
+void
+test_main (void) 
+{
+  int ids[REQ_CNT];
+  int handle;
+  int i;
+
+  for (i = 0; i < REQ_CNT * REQ_SIZE; i++)
+    data[i] = i % 253;
+
+  CHECK (create ("aio", sizeof data), "create \"aio\"");
+  CHECK ((handle = open ("aio")) > 1, "open \"aio\"");
+
+  for (i = 0; i < REQ_CNT; i++)
+    CHECK ((ids[i] = aio_write (handle, data + i * REQ_SIZE, REQ_SIZE,
+                                i * REQ_SIZE)) >= 0, "aio_write %d", i);
+  for (i = 0; i < REQ_CNT; i++)
+    CHECK (aio_wait (ids[i]) == REQ_SIZE, "aio_wait for write %d", i);
+
+  for (i = 0; i < REQ_CNT; i++)
+    CHECK ((ids[i] = aio_read (handle, buf + i * REQ_SIZE, REQ_SIZE,
+                               i * REQ_SIZE)) >= 0, "aio_read %d", i);
+  for (i = 0; i < REQ_CNT; i++)
+    {
+      int status = aio_poll (ids[i]);
+      CHECK (status == 0 || status == 1, "aio_poll for read %d", i);
+    }
+  for (i = REQ_CNT - 1; i >= 0; i--)
+    CHECK (aio_wait (ids[i]) == REQ_SIZE, "aio_wait for read %d", i);
+  compare_bytes (buf, data, sizeof data, 0, "aio");
+
+  CHECK (tell (handle) == 0, "tell \"aio\"");
+  check_file_handle (handle, "aio", data, sizeof data);
+}
@@ -0,0 +1,34 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-multi) begin
+(aio-multi) create "aio"
+(aio-multi) open "aio"
+(aio-multi) aio_write 0
+(aio-multi) aio_write 1
+(aio-multi) aio_write 2
+(aio-multi) aio_write 3
+(aio-multi) aio_wait for write 0
+(aio-multi) aio_wait for write 1
+(aio-multi) aio_wait for write 2
+(aio-multi) aio_wait for write 3
+(aio-multi) aio_read 0
+(aio-multi) aio_read 1
+(aio-multi) aio_read 2
+(aio-multi) aio_read 3
+(aio-multi) aio_poll for read 0
+(aio-multi) aio_poll for read 1
+(aio-multi) aio_poll for read 2
+(aio-multi) aio_poll for read 3
+(aio-multi) aio_wait for read 3
+(aio-multi) aio_wait for read 2
+(aio-multi) aio_wait for read 1
+(aio-multi) aio_wait for read 0
+(aio-multi) tell "aio"
+(aio-multi) verified contents of "aio"
+(aio-multi) end
+aio-multi: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Child process run by aio-exit test.
+
+   Writes sample.txt's contents to "aio" in several asynchronous
+   requests and exits without waiting for any of them. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+
+const char *test_name = "child-aio";
+
+#define REQ_CNT 4
+
+int
+main (void) 
+{
+  size_t file_size = sizeof sample - 1;
+  size_t size = (file_size + REQ_CNT - 1) / REQ_CNT;
+  size_t ofs;
+  int handle;
+
+  msg ("begin");
+  CHECK ((handle = open ("aio")) > 1, "open \"aio\"");
+  for (ofs = 0; ofs < file_size; ofs += size)
+    {
+      size_t len = file_size - ofs < size ? file_size - ofs : size;
+      if (aio_write (handle, sample + ofs, len, ofs) < 0)
+        fail ("aio_write at offset %zu failed", ofs);
+    }
+  msg ("end");
+
+  return 0;
+}
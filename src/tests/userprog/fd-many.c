@@ -0,0 +1,48 @@
+/* Opens more files than the descriptor table starts with room
+   for, closes every other one, and checks that reopening reuses
+   the freed descriptors instead of growing the table. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FD_CNT 200
+
+void
+test_main (void) 
+{
+  int fds[FD_CNT];
+  int max_fd = 0;
+  int i, j;
+
+  for (i = 0; i < FD_CNT; i++)
+    {
+      if ((fds[i] = open ("sample.txt")) < 2)
+        fail ("open %d of %d returned %d", i + 1, FD_CNT, fds[i]);
+      for (j = 0; j < i; j++)
+        if (fds[j] == fds[i])
+          fail ("opens %d and %d both returned %d", j + 1, i + 1, fds[i]);
+      if (fds[i] > max_fd)
+        max_fd = fds[i];
+    }
+  msg ("open \"sample.txt\" %d times", FD_CNT);
+  check_file_handle (fds[FD_CNT - 1], "sample.txt", sample, sizeof sample - 1);
+
+  for (i = 0; i < FD_CNT; i += 2)
+    close (fds[i]);
+  msg ("close every other descriptor");
+
+  for (i = 0; i < FD_CNT; i += 2)
+    {
+      int fd = open ("sample.txt");
+      for (j = 0; j < FD_CNT; j += 2)
+        if (fds[j] == fd)
+          break;
+      if (j >= FD_CNT)
+        fail ("reopen returned %d, not a closed descriptor", fd);
+      fds[j] = -1;
+    }
+  msg ("reopen reuses closed descriptors");
+  CHECK (open ("sample.txt") > max_fd, "open beyond reused descriptors");
+}
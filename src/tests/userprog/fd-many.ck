@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fd-many) begin
+(fd-many) open "sample.txt" 200 times
+(fd-many) verified contents of "sample.txt"
+(fd-many) close every other descriptor
+(fd-many) reopen reuses closed descriptors
+(fd-many) open beyond reused descriptors
+(fd-many) end
+fd-many: exit(0)
+EOF
+pass;
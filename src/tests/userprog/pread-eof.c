@@ -0,0 +1,22 @@
+/* Reads with pread() at and beyond the end of a file, which must
+   return 0. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[16];
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (pread (handle, buf, sizeof buf, sizeof sample - 1) == 0,
+         "pread at end of file");
+  CHECK (pread (handle, buf, sizeof buf, sizeof sample + 100) == 0,
+         "pread past end of file");
+  CHECK (pread (handle, buf, sizeof buf, sizeof sample - 5) == 4,
+         "pread across end of file");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-eof) begin
+(pread-eof) open "sample.txt"
+(pread-eof) pread at end of file
+(pread-eof) pread past end of file
+(pread-eof) pread across end of file
+(pread-eof) end
+pread-eof: exit(0)
+EOF
+pass;
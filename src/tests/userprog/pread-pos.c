@@ -0,0 +1,30 @@
+/* Checks that pread() and pwrite() transfer at the offset they
+   are given and leave the file position where it was. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[32];
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (read (handle, buf, 10) == 10, "read \"sample.txt\"");
+
+  CHECK (pread (handle, buf, 20, 50) == 20, "pread \"sample.txt\"");
+  compare_bytes (buf, sample + 50, 20, 50, "sample.txt");
+  CHECK (tell (handle) == 10, "tell after pread");
+
+  CHECK (pwrite (handle, "abcde", 5, 100) == 5, "pwrite \"sample.txt\"");
+  CHECK (tell (handle) == 10, "tell after pwrite");
+
+  CHECK (pread (handle, buf, 5, 100) == 5, "pread back \"sample.txt\"");
+  compare_bytes (buf, "abcde", 5, 100, "sample.txt");
+  CHECK (read (handle, buf, 10) == 10, "read \"sample.txt\" again");
+  compare_bytes (buf, sample + 10, 10, 10, "sample.txt");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pos) begin
+(pread-pos) open "sample.txt"
+(pread-pos) read "sample.txt"
+(pread-pos) pread "sample.txt"
+(pread-pos) tell after pread
+(pread-pos) pwrite "sample.txt"
+(pread-pos) tell after pwrite
+(pread-pos) pread back "sample.txt"
+(pread-pos) read "sample.txt" again
+(pread-pos) end
+pread-pos: exit(0)
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Passes buffer counts outside 0...IOV_MAX to readv() and
+   writev(), which must fail with -1. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static struct iovec iov[IOV_MAX + 1];
+  static char buf[IOV_MAX + 1];
+  int handle;
+  int i;
+
+  for (i = 0; i <= IOV_MAX; i++)
+    {
+      iov[i].iov_base = buf + i;
+      iov[i].iov_len = 1;
+    }
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (readv (handle, iov, -1) == -1, "readv with -1 buffers");
+  CHECK (readv (handle, iov, IOV_MAX + 1) == -1,
+         "readv with IOV_MAX + 1 buffers");
+  CHECK (writev (handle, iov, -1) == -1, "writev with -1 buffers");
+  CHECK (writev (handle, iov, IOV_MAX + 1) == -1,
+         "writev with IOV_MAX + 1 buffers");
+  CHECK (tell (handle) == 0, "tell \"sample.txt\"");
+  CHECK (readv (handle, iov, IOV_MAX) == IOV_MAX, "readv with IOV_MAX buffers");
+}
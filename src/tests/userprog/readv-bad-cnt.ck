@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-bad-cnt) begin
+(readv-bad-cnt) open "sample.txt"
+(readv-bad-cnt) readv with -1 buffers
+(readv-bad-cnt) readv with IOV_MAX + 1 buffers
+(readv-bad-cnt) writev with -1 buffers
+(readv-bad-cnt) writev with IOV_MAX + 1 buffers
+(readv-bad-cnt) tell "sample.txt"
+(readv-bad-cnt) readv with IOV_MAX buffers
+(readv-bad-cnt) end
+readv-bad-cnt: exit(0)
+EOF
+pass;
@@ -0,0 +1,54 @@
+/* Writes a file with writev() from several buffers, one of them
+   spanning several pages, then reads it back with readv() split
+   at different points and checks the contents. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define HEAD 10
+#define BODY 20000
+#define TAIL 100
+#define TOTAL (HEAD + BODY + TAIL)
+
+static char data[TOTAL];
+static char buf[TOTAL];
+
+void
+test_main (void) 
+{
+  struct iovec out[3], in[3];
+  int handle;
+  size_t i;
+
+  for (i = 0; i < TOTAL; i++)
+    data[i] = i % 251;
+
+  out[0].iov_base = data;
+  out[0].iov_len = HEAD;
+  out[1].iov_base = data + HEAD;
+  out[1].iov_len = BODY;
+  out[2].iov_base = data + HEAD + BODY;
+  out[2].iov_len = TAIL;
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  CHECK (writev (handle, out, 3) == TOTAL, "writev \"data\"");
+  CHECK (tell (handle) == TOTAL, "tell \"data\"");
+
+  in[0].iov_base = buf;
+  in[0].iov_len = 7;
+  in[1].iov_base = buf + 7;
+  in[1].iov_len = TOTAL - 60;
+  in[2].iov_base = buf + TOTAL - 53;
+  in[2].iov_len = 53;
+
+  msg ("seek \"data\"");
+  seek (handle, 0);
+  CHECK (readv (handle, in, 3) == TOTAL, "readv \"data\"");
+  compare_bytes (buf, data, TOTAL, 0, "data");
+  CHECK (readv (handle, in, 3) == 0, "readv \"data\" at end of file");
+  msg ("close \"data\"");
+  close (handle);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "data"
+(readv-writev) open "data"
+(readv-writev) writev "data"
+(readv-writev) tell "data"
+(readv-writev) seek "data"
+(readv-writev) readv "data"
+(readv-writev) readv "data" at end of file
+(readv-writev) close "data"
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Submits a ring WRITE request whose buffer is an invalid
+   pointer.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sys_ring ring __attribute__ ((aligned (4096)));
+
+void
+test_main (void) 
+{
+  struct ring_sqe *sqe = &ring.sq[0];
+  int handle;
+
+  CHECK (create ("ring", 0), "create \"ring\"");
+  CHECK ((handle = open ("ring")) > 1, "open \"ring\"");
+  CHECK (ring_setup (&ring), "ring_setup");
+
+  sqe->op = RING_OP_WRITE;
+  sqe->fd = handle;
+  sqe->buf = (char *) 0xc0100000;
+  sqe->len = 123;
+  ring.sq_tail++;
+  ring_enter (1);
+  fail ("should not have survived ring_enter()");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-bad-buf) begin
+(ring-bad-buf) create "ring"
+(ring-bad-buf) open "ring"
+(ring-bad-buf) ring_setup
+ring-bad-buf: exit(-1)
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Submits a NOP, a WRITE, and a PREAD through the syscall ring
+   in one ring_enter() call and checks their completions. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sys_ring ring __attribute__ ((aligned (4096)));
+
+/* Queues a request in RING. */
+static void
+queue (uint32_t op, int fd, void *buf, uint32_t len, uint32_t off,
+       uint32_t user_data) 
+{
+  struct ring_sqe *sqe = &ring.sq[ring.sq_tail % RING_SQ_ENTRIES];
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->off = off;
+  sqe->user_data = user_data;
+  ring.sq_tail++;
+}
+
+/* Reaps the next completion of RING and checks it. */
+static void
+reap (uint32_t user_data, int32_t res) 
+{
+  struct ring_cqe *cqe = &ring.cq[ring.cq_head % RING_CQ_ENTRIES];
+  CHECK (cqe->user_data == user_data && cqe->res == res,
+         "completion %u", (unsigned) user_data);
+  ring.cq_head++;
+}
+
+void
+test_main (void) 
+{
+  static char data[] = "ring buffer";
+  char buf[sizeof data];
+  int handle;
+
+  CHECK (create ("ring", 0), "create \"ring\"");
+  CHECK ((handle = open ("ring")) > 1, "open \"ring\"");
+  CHECK (ring_setup (&ring), "ring_setup");
+
+  queue (RING_OP_NOP, 0, NULL, 0, 0, 1);
+  queue (RING_OP_WRITE, handle, data, sizeof data, 0, 2);
+  queue (RING_OP_PREAD, handle, buf, sizeof buf, 0, 3);
+  CHECK (ring_enter (3) == 3, "ring_enter");
+  CHECK (ring.sq_head == 3 && ring.cq_tail == 3, "ring indexes");
+  reap (1, 0);
+  reap (2, sizeof data);
+  reap (3, sizeof buf);
+  compare_bytes (buf, data, sizeof data, 0, "ring");
+  CHECK (ring_enter (1) == 0, "ring_enter with empty queue");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-batch) begin
+(ring-batch) create "ring"
+(ring-batch) open "ring"
+(ring-batch) ring_setup
+(ring-batch) ring_enter
+(ring-batch) ring indexes
+(ring-batch) completion 1
+(ring-batch) completion 2
+(ring-batch) completion 3
+(ring-batch) ring_enter with empty queue
+(ring-batch) end
+ring-batch: exit(0)
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Fills the syscall ring's completion queue and checks that
+   ring_enter() stops until completions are reaped. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct sys_ring ring __attribute__ ((aligned (4096)));
+
+/* Queues CNT NOP requests in RING. */
+static void
+queue_nops (unsigned cnt) 
+{
+  while (cnt-- > 0)
+    {
+      struct ring_sqe *sqe = &ring.sq[ring.sq_tail % RING_SQ_ENTRIES];
+      sqe->op = RING_OP_NOP;
+      sqe->user_data = ring.sq_tail;
+      ring.sq_tail++;
+    }
+}
+
+void
+test_main (void) 
+{
+  CHECK (ring_setup (&ring), "ring_setup");
+
+  queue_nops (RING_SQ_ENTRIES);
+  CHECK (ring_enter (RING_SQ_ENTRIES) == RING_SQ_ENTRIES, "ring_enter");
+  queue_nops (RING_SQ_ENTRIES);
+  CHECK (ring_enter (RING_SQ_ENTRIES) == RING_SQ_ENTRIES, "ring_enter again");
+  CHECK (ring.cq_tail - ring.cq_head == RING_CQ_ENTRIES,
+         "completion queue full");
+
+  queue_nops (1);
+  CHECK (ring_enter (1) == 0, "ring_enter with full completion queue");
+  CHECK (ring.sq_head != ring.sq_tail, "request still queued");
+
+  ring.cq_head++;
+  CHECK (ring_enter (1) == 1, "ring_enter after reaping");
+  CHECK (ring.cq[(ring.cq_tail - 1) % RING_CQ_ENTRIES].user_data
+         == 2 * RING_SQ_ENTRIES, "last completion");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-cq-full) begin
+(ring-cq-full) ring_setup
+(ring-cq-full) ring_enter
+(ring-cq-full) ring_enter again
+(ring-cq-full) completion queue full
+(ring-cq-full) ring_enter with full completion queue
+(ring-cq-full) request still queued
+(ring-cq-full) ring_enter after reaping
+(ring-cq-full) last completion
+(ring-cq-full) end
+ring-cq-full: exit(0)
+EOF
+pass;
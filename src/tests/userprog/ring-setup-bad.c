@@ -0,0 +1,19 @@
+/* Passes ring_setup() a ring that is not page-aligned, then tries
+   to register a second ring.  Both must fail. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char pages[2][4096] __attribute__ ((aligned (4096)));
+
+void
+test_main (void) 
+{
+  CHECK (ring_enter (1) == -1, "ring_enter without a ring");
+  CHECK (!ring_setup ((struct sys_ring *) (pages[0] + 4)),
+         "ring_setup with unaligned ring");
+  CHECK (ring_setup ((struct sys_ring *) pages[0]), "ring_setup");
+  CHECK (!ring_setup ((struct sys_ring *) pages[1]),
+         "ring_setup with a second ring");
+}
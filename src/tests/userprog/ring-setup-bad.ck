@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-setup-bad) begin
+(ring-setup-bad) ring_enter without a ring
+(ring-setup-bad) ring_setup with unaligned ring
+(ring-setup-bad) ring_setup
+(ring-setup-bad) ring_setup with a second ring
+(ring-setup-bad) end
+ring-setup-bad: exit(0)
+EOF
+pass;
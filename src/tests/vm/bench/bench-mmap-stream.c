@@ -0,0 +1,66 @@
+/* Streams through a memory-mapped file twice the size of the user
+   pool, reading it twice and then rewriting it, so that every
+   page is faulted in from the file and, when written, written
+   back on eviction or unmap. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/bench.h"
+#include "tests/vm/bench/sweep.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define STREAM_PAGES (USER_PAGES * 2)
+#define STREAM_SIZE (STREAM_PAGES * PAGE_SIZE)
+
+static char buf[PAGE_SIZE];
+
+static void stream_read (const char *label, const unsigned *map);
+
+void
+test_main (void) 
+{
+  static const char file_name[] = "stream";
+  unsigned *map_addr = (unsigned *) 0x10000000;
+  struct bench b;
+  mapid_t map;
+  size_t ofs;
+  int fd;
+
+  if (!create (file_name, 0) || (fd = open (file_name)) < 2)
+    fail ("create and open \"%s\" failed", file_name);
+  memset (buf, 0x5a, sizeof buf);
+  for (ofs = 0; ofs < STREAM_SIZE; ofs += sizeof buf)
+    if (write (fd, buf, sizeof buf) != (int) sizeof buf)
+      fail ("write at offset %zu in \"%s\" failed", ofs, file_name);
+  if ((map = mmap (fd, map_addr)) == MAP_FAILED)
+    fail ("mmap \"%s\" failed", file_name);
+
+  stream_read ("mmap-read-cold", map_addr);
+  stream_read ("mmap-read-again", map_addr);
+
+  bench_begin (&b, "mmap-write-%d", STREAM_PAGES);
+  memset (map_addr, 0xa5, STREAM_SIZE);
+  munmap (map);
+  bench_end (&b, STREAM_PAGES, STREAM_SIZE);
+
+  close (fd);
+}
+
+/* Reads every word of the mapping at MAP, reporting it as
+   LABEL. */
+static void
+stream_read (const char *label, const unsigned *map) 
+{
+  struct bench b;
+  unsigned sum = 0;
+  size_t i;
+
+  bench_begin (&b, "%s-%d", label, STREAM_PAGES);
+  for (i = 0; i < STREAM_SIZE / sizeof *map; i++)
+    sum += map[i];
+  bench_end (&b, STREAM_PAGES, STREAM_SIZE);
+  if (sum != 0x5a5a5a5au * (STREAM_SIZE / sizeof *map))
+    fail ("mapping read back wrong data");
+}
@@ -0,0 +1,18 @@
+/* Sweeps working-set size with uniformly random accesses. */
+
+#include <random.h>
+#include "tests/vm/bench/sweep.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static size_t
+pick (size_t ws, size_t i UNUSED) 
+{
+  return random_ulong () % ws;
+}
+
+void
+test_main (void) 
+{
+  sweep ("random", pick);
+}
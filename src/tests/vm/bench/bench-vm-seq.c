@@ -0,0 +1,18 @@
+/* Sweeps working-set size with accesses that cycle through the
+   working set in order, the worst case for LRU-like replacement. */
+
+#include "tests/vm/bench/sweep.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static size_t
+pick (size_t ws, size_t i) 
+{
+  return i % ws;
+}
+
+void
+test_main (void) 
+{
+  sweep ("seq", pick);
+}
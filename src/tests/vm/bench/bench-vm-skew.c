@@ -0,0 +1,25 @@
+/* Sweeps working-set size with skewed accesses: nine in ten go
+   to a hot tenth of the working set, the rest anywhere in it.
+   A good replacement policy keeps the hot pages resident. */
+
+#include <random.h>
+#include "tests/vm/bench/sweep.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static size_t
+pick (size_t ws, size_t i UNUSED) 
+{
+  size_t hot = ws / 10 > 0 ? ws / 10 : 1;
+
+  if (random_ulong () % 10 != 0)
+    return random_ulong () % hot;
+  else
+    return random_ulong () % ws;
+}
+
+void
+test_main (void) 
+{
+  sweep ("skew", pick);
+}
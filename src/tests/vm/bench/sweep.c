@@ -0,0 +1,55 @@
+/* Working-set sweep shared by the page replacement benchmarks.
+
+   For each working-set size, from a quarter of the user pool to
+   three times its size, the caller's access pattern picks which
+   page of the working set each of ACCESS_CNT accesses touches,
+   and each access modifies one byte of that page.  Once the
+   working set outgrows the pool, every access that misses costs
+   an eviction and, because all pages are dirty, a swap-out. */
+
+#include "tests/vm/bench/sweep.h"
+#include "tests/bench.h"
+#include "tests/lib.h"
+
+#define PAGE_SIZE 4096
+#define ACCESS_CNT 2048
+
+/* Working-set sizes, in pages. */
+static const size_t sizes[] =
+  {
+    USER_PAGES / 4, USER_PAGES / 2, USER_PAGES * 3 / 4, USER_PAGES,
+    USER_PAGES * 3 / 2, USER_PAGES * 2, USER_PAGES * 3
+  };
+#define MAX_PAGES (USER_PAGES * 3)
+
+static char arena[MAX_PAGES][PAGE_SIZE];
+
+/* Runs the sweep, labeling each measurement with PATTERN.  PICK
+   returns the page, less than WS, that access I touches. */
+void
+sweep (const char *pattern, size_t (*pick) (size_t ws, size_t i)) 
+{
+  size_t s;
+
+  for (s = 0; s < sizeof sizes / sizeof *sizes; s++) 
+    {
+      size_t ws = sizes[s];
+      struct bench b;
+      size_t i;
+
+      /* Touch every page first, so that zero-fill faults are
+         not counted as replacement. */
+      for (i = 0; i < ws; i++)
+        arena[i][0] = 1;
+
+      bench_begin (&b, "%s-%zu-of-%d", pattern, ws, USER_PAGES);
+      for (i = 0; i < ACCESS_CNT; i++) 
+        {
+          size_t page = pick (ws, i);
+          if (page >= ws)
+            fail ("page %zu is outside a %zu-page working set", page, ws);
+          arena[page][i % PAGE_SIZE]++;
+        }
+      bench_end (&b, ACCESS_CNT, (unsigned long long) ACCESS_CNT * PAGE_SIZE);
+    }
+}
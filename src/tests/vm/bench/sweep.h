@@ -0,0 +1,12 @@
+#ifndef TESTS_VM_BENCH_SWEEP_H
+#define TESTS_VM_BENCH_SWEEP_H
+
+#include <stddef.h>
+
+/* User pool size the benchmarks run with.  Must match the -ul
+   option in tests/vm/bench/Make.tests. */
+#define USER_PAGES 128
+
+void sweep (const char *pattern, size_t (*pick) (size_t ws, size_t i));
+
+#endif /* tests/vm/bench/sweep.h */
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-fd-reuse) begin
+(mmap-fd-reuse) open "sample.txt"
+(mmap-fd-reuse) mmap "sample.txt"
+(mmap-fd-reuse) close "sample.txt"
+(mmap-fd-reuse) open "sample.txt" again
+(mmap-fd-reuse) mapped descriptor not reused
+(mmap-fd-reuse) descriptor reused after munmap
+(mmap-fd-reuse) end
+EOF
+pass;
@@ -22,13 +22,17 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/profile.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/elfcache.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "vm/frame.h"
+#include "vm/page.h"
 #include "vm/swap.h"
 #else
 #include "tests/threads/tests.h"
@@ -62,6 +66,12 @@ static const char *swap_bdev_name;
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
+/* -trace: Start event tracing during boot? */
+static bool trace_at_boot;
+
+/* -profile: Start profiling during boot? */
+static bool profile_at_boot;
+
 static void bss_init (void);
 static void paging_init (void);
 
@@ -115,6 +125,10 @@ main (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+  if (trace_at_boot && !trace_start ())
+    printf ("trace: out of memory, not tracing\n");
+  if (profile_at_boot && !profile_start ())
+    printf ("profile: out of memory, not profiling\n");
 
   /* Segmentation. */
   /* USERPROG is not defined this time, ignore */
@@ -144,7 +158,9 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  elf_cache_init ();
   frame_init();
+  page_init();
   swap_init();
 #endif
 
@@ -307,6 +323,10 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-trace"))
+        trace_at_boot = true;
+      else if (!strcmp (name, "-profile"))
+        profile_at_boot = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
@@ -366,6 +386,8 @@ run_actions (char **argv)
       {"rm", 2, fsutil_rm},
       {"extract", 1, fsutil_extract},
       {"append", 2, fsutil_append},
+      {"trace", 2, fsutil_trace},
+      {"profile", 2, fsutil_profile},
 #endif
       {NULL, 0, NULL},
     };
@@ -415,6 +437,10 @@ usage (void)
           "Use these actions indirectly via `pintos' -g and -p options:\n"
           "  extract            Untar from scratch device into file system.\n"
           "  append FILE        Append FILE to tar file on scratch device.\n"
+          "  trace FILE         Save the event trace to FILE; fetch it with\n"
+          "                     -g and decode it with pintos-trace.\n"
+          "  profile FILE       Save the profile to FILE; fetch it with\n"
+          "                     -g and symbolize it with pintos-profile.\n"
 #endif
           "\nOptions:\n"
           "  -h                 Print this help message and power off.\n"
@@ -430,6 +456,8 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -trace             Trace kernel events from boot onward.\n"
+          "  -profile           Sample the running code every timer tick.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
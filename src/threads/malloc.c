@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -32,7 +33,25 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   Each descriptor also keeps a small "magazine", a stack of
+   free blocks that malloc() and free() push and pop with
+   interrupts briefly disabled instead of taking the descriptor
+   lock.  Only when a magazine runs empty (or overflows) do we
+   take the lock, and then we move half a magazine's worth of
+   blocks at once.  Blocks sitting in a magazine still count as
+   in use by their arena, so an arena is only returned to the
+   page allocator once its blocks have drained back to the free
+   list.
+
+   Object caches are extra descriptors whose block size is the
+   exact size of one kind of object, such as `struct inode',
+   instead of the next power of 2.  They share the arena layout
+   and the magazines, so free() works on cached objects too. */
+
+/* Number of free blocks a descriptor's magazine can hold. */
+#define MAG_SIZE 16
 
 /* Descriptor. */
 struct desc
@@ -41,6 +60,9 @@ struct desc
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+    const char *name;           /* Object cache name, null for malloc. */
+    size_t mag_cnt;             /* Number of blocks in magazine. */
+    struct block *mag[MAG_SIZE]; /* Magazine of free blocks. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -64,6 +86,15 @@ struct block
 static struct desc descs[10];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Object cache descriptors, handed out by obj_cache_create(). */
+#define OBJ_CACHE_CNT 16
+static struct desc caches[OBJ_CACHE_CNT];
+static size_t cache_cnt;
+static struct lock cache_lock;  /* Protects cache_cnt. */
+
+static void desc_init (struct desc *, size_t block_size);
+static void *desc_alloc (struct desc *);
+static void desc_free (struct desc *, struct block *);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
@@ -77,11 +108,21 @@ malloc_init (void)
     {
       struct desc *d = &descs[desc_cnt++];
       ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-      d->block_size = block_size;
-      d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-      list_init (&d->free_list);
-      lock_init (&d->lock);
+      desc_init (d, block_size);
     }
+  lock_init (&cache_lock);
+}
+
+/* Initializes descriptor D for blocks of BLOCK_SIZE bytes. */
+static void
+desc_init (struct desc *d, size_t block_size) 
+{
+  d->block_size = block_size;
+  d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+  list_init (&d->free_list);
+  lock_init (&d->lock);
+  d->name = NULL;
+  d->mag_cnt = 0;
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -90,7 +131,6 @@ void *
 malloc (size_t size) 
 {
   struct desc *d;
-  struct block *b;
   struct arena *a;
 
   /* A null pointer satisfies a request for 0 bytes. */
@@ -119,6 +159,29 @@ malloc (size_t size)
       return a + 1;
     }
 
+  return desc_alloc (d);
+}
+
+/* Obtains a free block from descriptor D, preferring its
+   magazine.  Returns a null pointer if memory is not
+   available. */
+static void *
+desc_alloc (struct desc *d) 
+{
+  enum intr_level old_level;
+  struct block *b;
+  struct arena *a;
+
+  /* Fast path: pop a block from the magazine. */
+  old_level = intr_disable ();
+  if (d->mag_cnt > 0)
+    {
+      b = d->mag[--d->mag_cnt];
+      intr_set_level (old_level);
+      return b;
+    }
+  intr_set_level (old_level);
+
   lock_acquire (&d->lock);
 
   /* If the free list is empty, create a new arena. */
@@ -149,6 +212,24 @@ malloc (size_t size)
   b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
   a = block_to_arena (b);
   a->free_cnt--;
+
+  /* Refill half of the magazine while we hold the lock. */
+  while (!list_empty (&d->free_list))
+    {
+      struct block *c;
+
+      old_level = intr_disable ();
+      if (d->mag_cnt >= MAG_SIZE / 2)
+        {
+          intr_set_level (old_level);
+          break;
+        }
+      c = list_entry (list_pop_front (&d->free_list), struct block,
+                      free_elem);
+      block_to_arena (c)->free_cnt--;
+      d->mag[d->mag_cnt++] = c;
+      intr_set_level (old_level);
+    }
   lock_release (&d->lock);
   return b;
 }
@@ -227,42 +308,120 @@ free (void *p)
       if (d != NULL) 
         {
           /* It's a normal block.  We handle it here. */
+          desc_free (d, b);
+        }
+      else
+        {
+          /* It's a big block.  Free its pages. */
+          palloc_free_multiple (a, a->free_cnt);
+          return;
+        }
+    }
+}
+
+/* Returns block B to descriptor D, through its magazine if there
+   is room. */
+static void
+desc_free (struct desc *d, struct block *b) 
+{
+  enum intr_level old_level;
+  struct block *flush[MAG_SIZE / 2 + 1];
+  size_t flush_cnt = 0;
+  size_t i;
 
 #ifndef NDEBUG
-          /* Clear the block to help detect use-after-free bugs. */
-          memset (b, 0xcc, d->block_size);
+  /* Clear the block to help detect use-after-free bugs. */
+  memset (b, 0xcc, d->block_size);
 #endif
-  
-          lock_acquire (&d->lock);
 
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
+  /* Fast path: push the block onto the magazine.  If it is full,
+     take half of it out to be returned along with B. */
+  old_level = intr_disable ();
+  if (d->mag_cnt < MAG_SIZE)
+    {
+      d->mag[d->mag_cnt++] = b;
+      intr_set_level (old_level);
+      return;
+    }
+  while (flush_cnt < MAG_SIZE / 2)
+    flush[flush_cnt++] = d->mag[--d->mag_cnt];
+  intr_set_level (old_level);
+  flush[flush_cnt++] = b;
 
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
-            {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
-            }
+  lock_acquire (&d->lock);
+  for (i = 0; i < flush_cnt; i++) 
+    {
+      struct block *f = flush[i];
+      struct arena *a = block_to_arena (f);
 
-          lock_release (&d->lock);
-        }
-      else
+      /* Add block to free list. */
+      list_push_front (&d->free_list, &f->free_elem);
+
+      /* If the arena is now entirely unused, free it. */
+      if (++a->free_cnt >= d->blocks_per_arena) 
         {
-          /* It's a big block.  Free its pages. */
-          palloc_free_multiple (a, a->free_cnt);
-          return;
+          size_t j;
+
+          ASSERT (a->free_cnt == d->blocks_per_arena);
+          for (j = 0; j < d->blocks_per_arena; j++) 
+            {
+              struct block *c = arena_to_block (a, j);
+              list_remove (&c->free_elem);
+            }
+          palloc_free_page (a);
         }
     }
+  lock_release (&d->lock);
+}
+
+/* Creates an object cache for objects of exactly SIZE bytes,
+   named NAME for debugging purposes.  Objects are packed into
+   pages at SIZE (rounded up to a word) instead of the next power
+   of 2.  Returns a null pointer if no cache slot is free or SIZE
+   is too large for a single arena. */
+struct obj_cache *
+obj_cache_create (const char *name, size_t size) 
+{
+  struct desc *d = NULL;
+
+  ASSERT (name != NULL);
+
+  size = ROUND_UP (size, sizeof (void *));
+  if (size < sizeof (struct block))
+    size = sizeof (struct block);
+  if (size > PGSIZE - sizeof (struct arena))
+    return NULL;
+
+  lock_acquire (&cache_lock);
+  if (cache_cnt < OBJ_CACHE_CNT)
+    d = &caches[cache_cnt++];
+  lock_release (&cache_lock);
+  if (d == NULL)
+    return NULL;
+
+  desc_init (d, size);
+  d->name = name;
+  return (struct obj_cache *) d;
 }
-
+
+/* Obtains an uninitialized object from CACHE.
+   Returns a null pointer if memory is not available. */
+void *
+obj_cache_alloc (struct obj_cache *cache) 
+{
+  ASSERT (cache != NULL);
+
+  return desc_alloc ((struct desc *) cache);
+}
+
+/* Returns object P, which must have been obtained from
+   obj_cache_alloc(), to its cache.  Equivalent to free(P). */
+void
+obj_cache_free (struct obj_cache *cache UNUSED, void *p) 
+{
+  free (p);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -23,7 +24,31 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   The kernel pool is managed as a binary buddy system, so that
+   multi-page allocations (big malloc() blocks, the frame table,
+   the swap table) take O(log n) time instead of a first-fit scan
+   of the whole pool, and freed runs coalesce with their buddies.
+   A request that is not a power of 2 is carved out of the next
+   larger block and the unused tail is freed straight back.  The
+   buddy lists are protected by disabling interrupts rather than
+   by the pool lock, because thread pages are freed from
+   thread_schedule_tail() where sleeping is not allowed.  The user
+   pool hands out single frames and keeps using the bitmap.
+
+   The idle thread keeps a small stack of already-zeroed user
+   pages topped up (see palloc_refill_zeroed()), so that a
+   PAL_USER | PAL_ZERO request on a page fault usually skips the
+   4 kB memset.  Those pages are marked used in the user pool's
+   bitmap, so once the bitmap runs dry any user request drains
+   the stack before reporting failure. */
+
+/* Number of buddy orders: blocks of 1, 2, 4, ..., 2**15 pages. */
+#define BUDDY_ORDERS 16
+
+/* order_map value for a page that does not start a free block. */
+#define ORDER_NONE 0xff
 
 /* A memory pool. */
 struct pool
@@ -31,14 +56,31 @@ struct pool
     struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+
+    /* Buddy allocator, kernel pool only. */
+    bool buddy;                         /* Use the buddy allocator? */
+    uint8_t *order_map;                 /* Order of free block at page. */
+    struct list free_lists[BUDDY_ORDERS]; /* Free blocks by order. */
+    size_t free_blocks[BUDDY_ORDERS];   /* Length of each free list. */
+    size_t free_pages;                  /* Total free pages. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Pre-zeroed user pages, protected by disabling interrupts. */
+#define ZERO_PAGE_CNT 32
+static void *zero_pages[ZERO_PAGE_CNT];
+static size_t zero_cnt;
+static long long zero_hits;             /* # of requests served. */
+static long long zero_misses;           /* # of requests zeroed inline. */
+
 static void init_pool (struct pool *, void *base, size_t page_cnt,
-                       const char *name);
+                       const char *name, bool buddy);
 static bool page_from_pool (const struct pool *, void *page);
+static void *zero_page_pop (void);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -56,9 +98,9 @@ palloc_init (size_t user_page_limit)
   kernel_pages = free_pages - user_pages;
 
   /* Give half of memory to kernel, half to user. */
-  init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
+  init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool", true);
   init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
-             user_pages, "user pool");
+             user_pages, "user pool", false);
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
@@ -77,12 +119,30 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  if (pool == &user_pool && page_cnt == 1 && (flags & PAL_ZERO))
+    {
+      pages = zero_page_pop ();
+      if (pages != NULL)
+        {
+          zero_hits++;
+          return pages;
+        }
+      zero_misses++;
+    }
+
+  if (pool->buddy)
+    page_idx = buddy_alloc (pool, page_cnt);
+  else
+    {
+      lock_acquire (&pool->lock);
+      page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+      lock_release (&pool->lock);
+    }
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
+  else if (pool == &user_pool && page_cnt == 1)
+    pages = zero_page_pop ();
   else
     pages = NULL;
 
@@ -137,8 +197,13 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  if (pool->buddy)
+    buddy_free (pool, page_idx, page_cnt);
+  else
+    {
+      ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+      bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+    }
 }
 
 /* Frees the page at PAGE. */
@@ -148,15 +213,96 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Pops a page off the pre-zeroed stack.  Returns a null pointer
+   if the stack is empty. */
+static void *
+zero_page_pop (void) 
+{
+  enum intr_level old_level;
+  void *page = NULL;
+
+  old_level = intr_disable ();
+  if (zero_cnt > 0)
+    page = zero_pages[--zero_cnt];
+  intr_set_level (old_level);
+  return page;
+}
+
+/* Zeroes one free user page and adds it to the pre-zeroed stack.
+   Called by the idle thread with interrupts off; interrupts are
+   turned on while the page is cleared and are off again on
+   return.  Never sleeps.  Returns true if a page was added,
+   false if the stack is full or no page could be had. */
+bool
+palloc_refill_zeroed (void) 
+{
+  size_t page_idx;
+  void *page;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (zero_cnt >= ZERO_PAGE_CNT || !lock_try_acquire (&user_pool.lock))
+    return false;
+  page_idx = bitmap_scan_and_flip (user_pool.used_map, 0, 1, false);
+  lock_release (&user_pool.lock);
+  if (page_idx == BITMAP_ERROR)
+    return false;
+  page = user_pool.base + PGSIZE * page_idx;
+
+  intr_enable ();
+  memset (page, 0, PGSIZE);
+  intr_disable ();
+
+  if (zero_cnt < ZERO_PAGE_CNT)
+    zero_pages[zero_cnt++] = page;
+  else
+    bitmap_reset (user_pool.used_map, page_idx);
+  return true;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) 
+{
+  struct pool *p = &kernel_pool;
+  size_t largest = 0;
+  enum intr_level old_level;
+  int order;
+
+  old_level = intr_disable ();
+  for (order = BUDDY_ORDERS - 1; order >= 0; order--)
+    if (p->free_blocks[order] > 0)
+      {
+        largest = (size_t) 1 << order;
+        break;
+      }
+  printf ("Palloc: kernel pool %zu of %zu pages free, "
+          "largest free block %zu pages, %zu%% fragmented\n",
+          p->free_pages, bitmap_size (p->used_map), largest,
+          p->free_pages > 0 ? 100 - largest * 100 / p->free_pages : 0);
+  printf ("Palloc: free blocks by order:");
+  for (order = 0; order < BUDDY_ORDERS; order++)
+    printf (" %zu", p->free_blocks[order]);
+  printf ("\n");
+  printf ("Palloc: %lld zeroed user pages from idle pool, %lld zeroed inline\n",
+          zero_hits, zero_misses);
+  intr_set_level (old_level);
+}
+
 /* Initializes pool P as starting at START and ending at END,
-   naming it NAME for debugging purposes. */
+   naming it NAME for debugging purposes.  If BUDDY is true, the
+   pool is managed by the buddy allocator. */
 static void
-init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
+init_pool (struct pool *p, void *base, size_t page_cnt, const char *name,
+           bool buddy) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's used_map at its base, followed by the
+     buddy order map if there is one.  Calculate the space needed
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
+  size_t bm_bytes = ROUND_UP (bitmap_buf_size (page_cnt), sizeof (long));
+  size_t om_bytes = buddy ? page_cnt : 0;
+  size_t bm_pages = DIV_ROUND_UP (bm_bytes + om_bytes, PGSIZE);
+  size_t i;
   if (bm_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
   page_cnt -= bm_pages;
@@ -165,8 +311,150 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
 
   /* Initialize the pool. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_bytes);
   p->base = base + bm_pages * PGSIZE;
+  p->buddy = buddy;
+  if (!buddy)
+    return;
+
+  /* Start with every page allocated, then free the whole pool,
+     which splits it into maximal aligned blocks. */
+  p->order_map = (uint8_t *) base + bm_bytes;
+  memset (p->order_map, ORDER_NONE, page_cnt);
+  for (i = 0; i < BUDDY_ORDERS; i++)
+    {
+      list_init (&p->free_lists[i]);
+      p->free_blocks[i] = 0;
+    }
+  p->free_pages = 0;
+  bitmap_set_all (p->used_map, true);
+  buddy_free (p, 0, page_cnt);
+}
+
+/* Returns the list element stored at the start of free page
+   PAGE_IDX in buddy pool P. */
+static struct list_elem *
+buddy_elem (struct pool *p, size_t page_idx) 
+{
+  return (struct list_elem *) (p->base + PGSIZE * page_idx);
+}
+
+/* Puts the block of 2**ORDER pages at PAGE_IDX on P's free
+   lists. */
+static void
+buddy_insert (struct pool *p, size_t page_idx, int order) 
+{
+  p->order_map[page_idx] = order;
+  list_push_front (&p->free_lists[order], buddy_elem (p, page_idx));
+  p->free_blocks[order]++;
+  p->free_pages += (size_t) 1 << order;
+}
+
+/* Takes the free block of 2**ORDER pages at PAGE_IDX off P's
+   free lists. */
+static void
+buddy_remove (struct pool *p, size_t page_idx, int order) 
+{
+  ASSERT (p->order_map[page_idx] == order);
+  p->order_map[page_idx] = ORDER_NONE;
+  list_remove (buddy_elem (p, page_idx));
+  p->free_blocks[order]--;
+  p->free_pages -= (size_t) 1 << order;
+}
+
+/* Returns the largest order of a block that may start at
+   PAGE_IDX and that fits within CNT pages. */
+static int
+buddy_fit_order (size_t page_idx, size_t cnt) 
+{
+  int order = 0;
+
+  while (order + 1 < BUDDY_ORDERS
+         && page_idx % ((size_t) 2 << order) == 0
+         && ((size_t) 2 << order) <= cnt)
+    order++;
+  return order;
+}
+
+/* Allocates PAGE_CNT contiguous pages from buddy pool P and
+   returns the index of the first, or BITMAP_ERROR if no block is
+   large enough. */
+static size_t
+buddy_alloc (struct pool *p, size_t page_cnt) 
+{
+  enum intr_level old_level;
+  size_t page_idx;
+  int order, want;
+
+  for (want = 0; want < BUDDY_ORDERS; want++)
+    if (((size_t) 1 << want) >= page_cnt)
+      break;
+  if (want == BUDDY_ORDERS)
+    return BITMAP_ERROR;
+
+  old_level = intr_disable ();
+  for (order = want; order < BUDDY_ORDERS; order++)
+    if (!list_empty (&p->free_lists[order]))
+      break;
+  if (order == BUDDY_ORDERS)
+    {
+      intr_set_level (old_level);
+      return BITMAP_ERROR;
+    }
+
+  /* Take the block and split off upper halves until it is just
+     big enough. */
+  page_idx = pg_no (list_front (&p->free_lists[order])) - pg_no (p->base);
+  buddy_remove (p, page_idx, order);
+  while (order > want)
+    {
+      order--;
+      buddy_insert (p, page_idx + ((size_t) 1 << order), order);
+    }
+  bitmap_set_multiple (p->used_map, page_idx, (size_t) 1 << want, true);
+
+  /* Give back the tail we don't need. */
+  if (((size_t) 1 << want) > page_cnt)
+    buddy_free (p, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+  intr_set_level (old_level);
+
+  return page_idx;
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX to buddy pool
+   P, merging each block with its buddy for as long as the buddy
+   is free too. */
+static void
+buddy_free (struct pool *p, size_t page_idx, size_t page_cnt) 
+{
+  size_t pool_cnt = bitmap_size (p->used_map);
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  ASSERT (bitmap_all (p->used_map, page_idx, page_cnt));
+  bitmap_set_multiple (p->used_map, page_idx, page_cnt, false);
+  while (page_cnt > 0)
+    {
+      int order = buddy_fit_order (page_idx, page_cnt);
+      size_t idx = page_idx;
+      size_t size = (size_t) 1 << order;
+
+      page_idx += size;
+      page_cnt -= size;
+      while (order + 1 < BUDDY_ORDERS)
+        {
+          size_t buddy = idx ^ ((size_t) 1 << order);
+          if (buddy + ((size_t) 1 << order) > pool_cnt
+              || p->order_map[buddy] != order)
+            break;
+          buddy_remove (p, buddy, order);
+          if (buddy < idx)
+            idx = buddy;
+          order++;
+        }
+      buddy_insert (p, idx, order);
+    }
+  intr_set_level (old_level);
 }
 
 /* Returns true if PAGE was allocated from POOL,
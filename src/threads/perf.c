@@ -0,0 +1,190 @@
+#include "threads/perf.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Every counter, named ones first and then one per system
+   call number.  See lib/perfctr.h. */
+struct perf_ctr perf_counters[PERF_TOTAL];
+
+/* Descriptions of the named counters. */
+static const char *perf_names[PERF_CNT] =
+  {
+#define PERF_NAME(NAME, DESC) DESC,
+    PERF_COUNTERS (PERF_NAME)
+#undef PERF_NAME
+  };
+
+/* System-wide latency histograms. */
+static perf_hist_t perf_lat;
+
+/* Pages in a process's private latency histograms. */
+#define LAT_PAGES DIV_ROUND_UP (sizeof (perf_hist_t), PGSIZE)
+
+static void print_hist (const char *who, perf_hist_t *hist);
+
+/* Returns the value of counter ID, which must be less than
+   PERF_TOTAL. */
+uint64_t
+perf_get (unsigned id) 
+{
+  enum intr_level old_level;
+  uint64_t value;
+
+  /* Keep an interrupt from carrying into the high word between
+     the two reads. */
+  old_level = intr_disable ();
+  value = ((uint64_t) perf_counters[id].hi << 32) | perf_counters[id].lo;
+  intr_set_level (old_level);
+  return value;
+}
+
+/* Prints the counters that are nonzero. */
+void
+perf_print_stats (void) 
+{
+  unsigned id;
+
+  printf ("Perf:");
+  for (id = 0; id < PERF_CNT; id++)
+    if (perf_get (id) != 0)
+      printf (" %llu %s,", perf_get (id), perf_names[id]);
+  printf ("\nPerf: system calls by number:");
+  for (id = 0; id < PERF_SYSCALL_CNT; id++)
+    if (perf_get (PERF_SYSCALL_BASE + id) != 0)
+      printf (" %u:%llu", id, perf_get (PERF_SYSCALL_BASE + id));
+  printf ("\n");
+  print_hist ("kernel", &perf_lat);
+}
+
+/* Adds one to *C without disabling interrupts. */
+static inline void
+hist_inc (uint32_t *c) 
+{
+  asm volatile ("incl %0" : "+m" (*c));
+}
+
+/* Returns the histogram bucket for an event that took CYCLES. */
+static unsigned
+lat_bucket (uint64_t cycles) 
+{
+  uint32_t hi = cycles >> 32;
+  uint32_t lo = cycles;
+  unsigned bucket;
+
+  if (hi != 0)
+    bucket = 63 - __builtin_clz (hi);
+  else if (lo != 0)
+    bucket = 31 - __builtin_clz (lo);
+  else
+    bucket = 0;
+  return bucket < PERF_LAT_BUCKETS ? bucket : PERF_LAT_BUCKETS - 1;
+}
+
+/* Records that an event of kind ID, which began when the
+   time-stamp counter read START, has just finished.  It counts
+   system-wide and, if the current process asked with
+   perf_lat_track(), in its own histograms too. */
+void
+perf_lat_record (unsigned id, uint64_t start) 
+{
+  unsigned bucket = lat_bucket (rdtsc () - start);
+
+  ASSERT (id < PERF_LAT_TOTAL);
+  hist_inc (&perf_lat[id][bucket]);
+#ifdef USERPROG
+  if (thread_current ()->lat_hist != NULL)
+    hist_inc (&(*thread_current ()->lat_hist)[id][bucket]);
+#endif
+}
+
+/* Starts keeping latency histograms for the current process.
+   Returns true if successful or it already was, false if out of
+   memory. */
+bool
+perf_lat_track (void) 
+{
+#ifdef USERPROG
+  struct thread *t = thread_current ();
+  if (t->lat_hist == NULL)
+    t->lat_hist = palloc_get_multiple (PAL_ZERO, LAT_PAGES);
+  return t->lat_hist != NULL;
+#else
+  return false;
+#endif
+}
+
+/* Copies histogram ID into the PERF_LAT_BUCKETS elements of
+   BUCKETS: the current process's own if SELF, otherwise the
+   system-wide one.  Returns false if ID is out of range or SELF
+   is set but the process is not being tracked. */
+bool
+perf_lat_read (unsigned id, bool self, uint32_t *buckets) 
+{
+  perf_hist_t *hist = &perf_lat;
+
+  if (id >= PERF_LAT_TOTAL)
+    return false;
+  if (self)
+    {
+#ifdef USERPROG
+      hist = thread_current ()->lat_hist;
+#else
+      hist = NULL;
+#endif
+      if (hist == NULL)
+        return false;
+    }
+  memcpy (buckets, (*hist)[id], sizeof (*hist)[id]);
+  return true;
+}
+
+/* Prints and frees the current process's latency histograms, if
+   it kept any.  Called on process exit. */
+void
+perf_lat_exit (void) 
+{
+#ifdef USERPROG
+  struct thread *t = thread_current ();
+  if (t->lat_hist != NULL)
+    {
+      print_hist (t->name, t->lat_hist);
+      palloc_free_multiple (t->lat_hist, LAT_PAGES);
+      t->lat_hist = NULL;
+    }
+#endif
+}
+
+/* Prints each nonempty histogram in HIST, labeled with WHO, as
+   its event count followed by "[2^B]=N" for each nonempty
+   bucket B. */
+static void
+print_hist (const char *who, perf_hist_t *hist) 
+{
+  unsigned id, b;
+
+  for (id = 0; id < PERF_LAT_TOTAL; id++)
+    {
+      uint64_t total = 0;
+      for (b = 0; b < PERF_LAT_BUCKETS; b++)
+        total += (*hist)[id][b];
+      if (total == 0)
+        continue;
+
+      if (id < PERF_LAT_FAULT_BASE)
+        printf ("Latency (%s): system call %u: %llu,", who,
+                id - PERF_LAT_SYSCALL_BASE, total);
+      else
+        printf ("Latency (%s): %s: %llu,", who,
+                perf_names[PERF_PF_ZERO + id - PERF_LAT_FAULT_BASE], total);
+      for (b = 0; b < PERF_LAT_BUCKETS; b++)
+        if ((*hist)[id][b] != 0)
+          printf (" [2^%u]=%u", b, (unsigned) (*hist)[id][b]);
+      printf ("\n");
+    }
+}
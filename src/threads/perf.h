@@ -0,0 +1,58 @@
+#ifndef THREADS_PERF_H
+#define THREADS_PERF_H
+
+#include <perfctr.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A 64-bit event counter, kept as two words so it can be
+   bumped without disabling interrupts. */
+struct perf_ctr
+  {
+    uint32_t lo;
+    uint32_t hi;
+  };
+
+extern struct perf_ctr perf_counters[PERF_TOTAL];
+
+/* Adds one to counter ID.  The add and the carry into the high
+   word are separate instructions, but an interrupt handler that
+   bumps the same counter in between leaves the saved carry flag
+   alone, so no count is lost on this uniprocessor. */
+static inline void
+perf_inc (unsigned id) 
+{
+  struct perf_ctr *c = &perf_counters[id];
+  asm volatile ("addl $1, %0; adcl $0, %1"
+                : "+m" (c->lo), "+m" (c->hi) : : "cc");
+}
+
+/* Counts a call to system call NR. */
+static inline void
+perf_syscall (unsigned nr) 
+{
+  if (nr < PERF_SYSCALL_CNT)
+    perf_inc (PERF_SYSCALL_BASE + nr);
+}
+
+/* A set of latency histograms, one per PERF_LAT_* id. */
+typedef uint32_t perf_hist_t[PERF_LAT_TOTAL][PERF_LAT_BUCKETS];
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void) 
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+uint64_t perf_get (unsigned id);
+void perf_print_stats (void);
+
+void perf_lat_record (unsigned id, uint64_t start);
+bool perf_lat_track (void);
+bool perf_lat_read (unsigned id, bool self, uint32_t *buckets);
+void perf_lat_exit (void);
+
+#endif /* threads/perf.h */
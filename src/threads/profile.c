@@ -0,0 +1,201 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/pagedir.h"
+#endif
+
+/* Statistical profiling.
+
+   Every timer tick while profiling is on, the interrupted program
+   counter and the chain of return addresses above it are
+   appended to a buffer, together with the running thread.  Kernel
+   code and user programs are both built with frame pointers, so
+   following saved %ebp values is enough to recover the call
+   chain.  Samples stop, and are counted as dropped, once the
+   buffer fills.
+
+   The buffer holds the profile exactly as the "profile" action
+   saves it: a struct profile_header, the names of the sampled
+   threads, then the samples.  utils/pintos-profile symbolizes it
+   against kernel.o and the user programs. */
+
+/* Size of the buffer. */
+#define PROFILE_PAGES 32
+#define PROFILE_SAMPLES                                                 \
+  ((PROFILE_PAGES * PGSIZE - sizeof (struct profile_header)             \
+    - PROFILE_THREADS * sizeof (struct profile_thread))                 \
+   / sizeof (struct profile_sample))
+
+bool profile_on;
+
+/* Allocated on first start. */
+static struct profile_header *header;
+static struct profile_thread *threads;
+static struct profile_sample *samples;
+
+static void note_thread (struct thread *);
+static void unwind_kernel (struct thread *, uint32_t *frame,
+                           struct profile_sample *);
+static void unwind_user (struct thread *, uint32_t frame,
+                         struct profile_sample *);
+
+/* Starts profiling, allocating the buffer the first time.
+   Returns false if out of memory. */
+bool
+profile_start (void)
+{
+  if (header == NULL)
+    {
+      header = palloc_get_multiple (PAL_ZERO, PROFILE_PAGES);
+      if (header == NULL)
+        return false;
+      threads = (struct profile_thread *) (header + 1);
+      samples = (struct profile_sample *) (threads + PROFILE_THREADS);
+
+      memcpy (header->magic, "PPRF", 4);
+      header->version = PROFILE_VERSION;
+      header->sample_size = sizeof (struct profile_sample);
+      header->thread_cnt = PROFILE_THREADS;
+      header->hz = TIMER_FREQ;
+    }
+  profile_on = true;
+  return true;
+}
+
+/* Stops profiling.  The samples taken so far are kept. */
+void
+profile_stop (void)
+{
+  profile_on = false;
+}
+
+/* Records a sample of the context interrupted by F.  Called from
+   the timer interrupt handler. */
+void
+profile_sample (struct intr_frame *f)
+{
+  struct thread *t = thread_current ();
+  struct profile_sample *s;
+
+  ASSERT (intr_context ());
+
+  if (header->sample_cnt >= PROFILE_SAMPLES)
+    {
+      header->dropped_cnt++;
+      return;
+    }
+  s = &samples[header->sample_cnt++];
+  s->tid = t->tid;
+  s->user = (f->cs & 3) != 0;           /* Interrupted outside ring 0? */
+  s->pc[0] = (uint32_t) f->eip;
+  s->depth = 1;
+  if (s->user)
+    unwind_user (t, (uint32_t) f->ebp, s);
+  else
+    unwind_kernel (t, (uint32_t *) f->ebp, s);
+  note_thread (t);
+}
+
+/* Returns the number of bytes in the profile as profile_read()
+   presents it. */
+size_t
+profile_size (void)
+{
+  if (header == NULL)
+    return 0;
+  return ((uint8_t *) &samples[header->sample_cnt]) - (uint8_t *) header;
+}
+
+/* Copies up to SIZE bytes of the profile, starting at byte offset
+   OFS, into BUFFER, and returns the number of bytes copied.
+   Profiling should be stopped while the profile is read. */
+size_t
+profile_read (size_t ofs, void *buffer, size_t size)
+{
+  size_t total = profile_size ();
+
+  if (ofs >= total)
+    return 0;
+  if (size > total - ofs)
+    size = total - ofs;
+  memcpy (buffer, (uint8_t *) header + ofs, size);
+  return size;
+}
+
+/* Remembers T's name, unless it is already known or there is no
+   more room. */
+static void
+note_thread (struct thread *t)
+{
+  static tid_t last_tid;
+  size_t i;
+
+  if (t->tid == last_tid)
+    return;
+  last_tid = t->tid;
+
+  for (i = 0; i < PROFILE_THREADS; i++)
+    if (threads[i].tid == (uint32_t) t->tid)
+      return;
+    else if (threads[i].tid == 0)
+      {
+        threads[i].tid = t->tid;
+        strlcpy (threads[i].name, t->name, sizeof threads[i].name);
+        return;
+      }
+}
+
+/* Appends to S the return addresses found by following the
+   kernel frame pointer chain from FRAME, which must stay within
+   T's kernel stack. */
+static void
+unwind_kernel (struct thread *t, uint32_t *frame, struct profile_sample *s)
+{
+  while (s->depth < PROFILE_DEPTH
+         && pg_round_down (frame) == t
+         && (void *) frame > (void *) (t + 1)
+         && pg_ofs (frame) <= PGSIZE - 2 * sizeof *frame
+         && frame[1] != 0)
+    {
+      uint32_t *next = (uint32_t *) frame[0];
+
+      s->pc[s->depth++] = frame[1];
+      if (next <= frame)
+        break;
+      frame = next;
+    }
+}
+
+/* Appends to S the return addresses found by following the user
+   frame pointer chain from FRAME.  The chain is read through T's
+   page directory, so a frame that is not in memory just ends
+   it instead of faulting. */
+static void
+unwind_user (struct thread *t UNUSED, uint32_t frame UNUSED,
+             struct profile_sample *s UNUSED)
+{
+#ifdef USERPROG
+  while (s->depth < PROFILE_DEPTH
+         && t->pagedir != NULL
+         && frame != 0
+         && frame % sizeof (uint32_t) == 0
+         && is_user_vaddr ((void *) frame)
+         && pg_ofs ((void *) frame) <= PGSIZE - 2 * sizeof (uint32_t))
+    {
+      uint32_t *kframe = pagedir_get_page (t->pagedir, (void *) frame);
+
+      if (kframe == NULL || kframe[1] == 0)
+        break;
+      s->pc[s->depth++] = kframe[1];
+      if (kframe[0] <= frame)
+        break;
+      frame = kframe[0];
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct intr_frame;
+
+/* Most program counters kept per sample: the interrupted EIP
+   followed by up to PROFILE_DEPTH - 1 return addresses. */
+#define PROFILE_DEPTH 12
+
+/* Most threads whose names the profile remembers. */
+#define PROFILE_THREADS 64
+
+/* One timer-tick sample. */
+struct profile_sample
+  {
+    uint32_t tid;               /* Thread that was running. */
+    uint16_t user;              /* 1 if it was in user mode. */
+    uint16_t depth;             /* Number of valid entries in PC. */
+    uint32_t pc[PROFILE_DEPTH]; /* Innermost first. */
+  };
+
+/* Name of a sampled thread.  Unused entries have TID 0. */
+struct profile_thread
+  {
+    uint32_t tid;
+    char name[16];
+  };
+
+/* Profile file header, followed by PROFILE_THREADS struct
+   profile_thread and then SAMPLE_CNT struct profile_sample. */
+struct profile_header
+  {
+    char magic[4];              /* "PPRF". */
+    uint32_t version;           /* PROFILE_VERSION. */
+    uint32_t sample_size;       /* sizeof (struct profile_sample). */
+    uint32_t sample_cnt;        /* Number of samples taken. */
+    uint32_t thread_cnt;        /* PROFILE_THREADS. */
+    uint32_t dropped_cnt;       /* Samples lost to a full buffer. */
+    uint32_t hz;                /* Samples per second (TIMER_FREQ). */
+  };
+
+#define PROFILE_VERSION 1
+
+/* True while profiling. */
+extern bool profile_on;
+
+bool profile_start (void);
+void profile_stop (void);
+void profile_sample (struct intr_frame *);
+size_t profile_size (void);
+size_t profile_read (size_t ofs, void *buffer, size_t size);
+
+/* Samples the context interrupted by timer interrupt frame F, if
+   profiling. */
+static inline void
+profile_tick (struct intr_frame *f)
+{
+  if (profile_on)
+    profile_sample (f);
+}
+
+#endif /* threads/profile.h */
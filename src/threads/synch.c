@@ -35,11 +35,14 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
+#include "threads/perf.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 
-bool sema_cmp( const struct list_elem *a,
-            const struct list_elem *b,
-            void * aux);
+static bool waiter_greater (const struct list_elem *a,
+                            const struct list_elem *b, void *aux);
+static bool sema_elem_greater (const struct list_elem *a,
+                               const struct list_elem *b, void *aux);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -48,8 +51,13 @@ bool sema_cmp( const struct list_elem *a,
    - down or "P": wait for the value to become positive, then
      decrement it.
 
-   - up or "V": increment the value (and wake up one waiting
-     thread, if any). */
+    - up or "V": increment the value (and wake up one waiting
+     thread, if any).
+
+   Waiters are kept sorted by priority, highest first, and
+   threads of equal priority queue up in FIFO order, so waking
+   the next one is O(1).  synch_requeue() keeps the order right
+   when a waiter's priority changes through donation. */
 void
 sema_init (struct semaphore *sema, unsigned value) 
 {
@@ -77,7 +85,9 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0) 
     {
-      list_push_back (&sema->waiters, &thread_current ()->elem);
+      list_insert_ordered (&sema->waiters, &thread_current ()->elem,
+                           waiter_greater, NULL);
+      thread_current ()->blocked_sema = sema;
       thread_block ();
     }
   sema->value--;
@@ -141,10 +151,10 @@ sema_up (struct semaphore *sema)
           }
         }
     }
-    /* Select the thread with highest priority to wake up */
-    struct list_elem *m = list_max(&sema->waiters, thread_cmp, NULL);
-    list_remove(m);
-    struct thread *t = list_entry (m,struct thread, elem);
+    /* The front waiter has the highest priority */
+    struct thread *t = list_entry (list_pop_front (&sema->waiters),
+                                   struct thread, elem);
+    t->blocked_sema = NULL;
     thread_unblock(t);
   }
   intr_set_level (old_level);
@@ -225,9 +235,12 @@ lock_acquire (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
+  enum intr_level old_level = intr_disable ();
   struct thread *t = lock->holder;
   if(t != NULL)
   {
+    perf_inc (PERF_LOCK_CONTENDED);
+    trace (TRACE_LOCK_WAIT, (uint32_t) lock, t->tid);
     /* Add current thread to the waiter list of holder */
     DBG_MSG_THREAD("[%s] adding to %s waiters \n", thread_name(), t->name);
     list_push_back(&t->waiters, &thread_current()->wait_elem);
@@ -237,6 +250,7 @@ lock_acquire (struct lock *lock)
     if (thread_current()->priority > t->priority) 
     {
       t->priority = thread_current()->priority;
+      synch_requeue(t);
     }
     /* Donate priority to holder waitee if neccessary */
     struct thread * tmp = t->waitee;
@@ -244,11 +258,15 @@ lock_acquire (struct lock *lock)
     while(tmp != NULL)
     {
       if(donated_priority > tmp->priority)
+      {
         tmp->priority = donated_priority;
+        synch_requeue(tmp);
+      }
       else donated_priority = tmp->priority;
       tmp = tmp->waitee; 
     }
   }
+  intr_set_level (old_level);
   sema_down (&lock->semaphore);
   /* Got the lock */
   /* Current waitee is set to NULL and current thread is removed from
@@ -257,6 +275,7 @@ lock_acquire (struct lock *lock)
   /* Adjust former holder priority */
   if(t != NULL) 
   {
+    trace (TRACE_LOCK_ACQUIRE, (uint32_t) lock, 0);
     if(!list_empty(&t->waiters))
     {
       /* Make sure thread have higher priority than its waiters */
@@ -269,6 +288,7 @@ lock_acquire (struct lock *lock)
       else t->priority = t->non_donated_priority;
     }
     else t->priority = t->non_donated_priority;
+    synch_requeue(t);
   }
 }
 
@@ -323,6 +343,7 @@ struct semaphore_elem
   {
     struct list_elem elem;              /* List element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
 /* Initializes condition variable COND.  A condition variable
@@ -355,11 +376,16 @@ cond_init (struct condition *cond)
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
-   we need to sleep. */
+   we need to sleep.
+
+   Waiters are queued by priority, FIFO among equals, and a
+   waiter that receives a donation while it sleeps moves up the
+   queue, so cond_signal() always wakes the most urgent one. */
 void
 cond_wait (struct condition *cond, struct lock *lock) 
 {
   struct semaphore_elem waiter;
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
@@ -367,7 +393,12 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
-  list_push_back (&cond->waiters, &waiter.elem);
+  waiter.thread = thread_current ();
+  old_level = intr_disable ();
+  list_insert_ordered (&cond->waiters, &waiter.elem, sema_elem_greater, NULL);
+  thread_current ()->blocked_cond = cond;
+  thread_current ()->cond_elem = &waiter.elem;
+  intr_set_level (old_level);
   lock_release (lock);
   sema_down (&waiter.semaphore);
   lock_acquire (lock);
@@ -388,13 +419,16 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
+  enum intr_level old_level = intr_disable ();
   if (!list_empty (&cond->waiters)) 
   {
-    /* Select the semaphore with highest priority in waiters */
-    struct list_elem *e = list_max(&cond->waiters, sema_cmp, NULL);
-    list_remove(e);
-    sema_up (&list_entry (e,struct semaphore_elem, elem)->semaphore);
+    /* The front waiter has the highest priority */
+    struct semaphore_elem *w = list_entry (list_pop_front (&cond->waiters),
+                                           struct semaphore_elem, elem);
+    w->thread->blocked_cond = NULL;
+    sema_up (&w->semaphore);
   }
+  intr_set_level (old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -413,19 +447,141 @@ cond_broadcast (struct condition *cond, struct lock *lock)
     cond_signal (cond, lock);
 }
 
-/* TODO: Implement list_less_func for semaphore */
-bool sema_cmp( const struct list_elem *a,
-            const struct list_elem *b,
-            void * aux)
-  {
-    struct semaphore_elem *s1, *s2;
-    struct thread *t1, *t2;
-    s1 = list_entry(a, struct semaphore_elem, elem);
-    s2 = list_entry(b, struct semaphore_elem, elem);
-    t1 = list_entry(list_max(&(&s1->semaphore)->waiters, thread_cmp, NULL), 
-                    struct thread, elem);
-    t2 = list_entry(list_max(&(&s2->semaphore)->waiters, thread_cmp, NULL), 
-                    struct thread, elem);
-    if(t1->priority < t2->priority) return true;
-    else return false;
-  }
\ No newline at end of file
+/* Initializes readers-writer lock RW.  Waiters on either side
+   are woken through condition variables, so the highest-priority
+   waiter is always served first, exactly as for a plain lock. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  cond_init (&rw->read_ok);
+  cond_init (&rw->write_ok);
+  rw->readers = 0;
+  rw->waiting_writers = 0;
+  rw->writer = NULL;
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   while any writer is waiting for it.  The latter keeps a steady
+   stream of readers from starving writers.  Read locks are not
+   recursive: a reader that re-enters while a writer waits will
+   deadlock. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != thread_current ());
+
+  lock_acquire (&rw->lock);
+  while (rw->writer != NULL || rw->waiting_writers > 0)
+    cond_wait (&rw->read_ok, &rw->lock);
+  rw->readers++;
+  lock_release (&rw->lock);
+}
+
+/* Releases a read hold on RW.  The last reader out hands the
+   lock to a waiting writer, if any. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->readers > 0);
+  if (--rw->readers == 0 && rw->waiting_writers > 0)
+    cond_signal (&rw->write_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Acquires RW for writing, sleeping until there is neither an
+   active writer nor any active reader. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != thread_current ());
+
+  lock_acquire (&rw->lock);
+  rw->waiting_writers++;
+  while (rw->writer != NULL || rw->readers > 0)
+    cond_wait (&rw->write_ok, &rw->lock);
+  rw->waiting_writers--;
+  rw->writer = thread_current ();
+  lock_release (&rw->lock);
+}
+
+/* Releases the write hold on RW, which must be owned by the
+   current thread.  Another writer is preferred; otherwise every
+   blocked reader is let in at once. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (rwlock_held_by_current_thread (rw));
+
+  lock_acquire (&rw->lock);
+  rw->writer = NULL;
+  if (rw->waiting_writers > 0)
+    cond_signal (&rw->write_ok, &rw->lock);
+  else
+    cond_broadcast (&rw->read_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing.
+   Readers are anonymous, so a read hold cannot be checked. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
+
+/* Repositions thread T in the wait queues it is blocked on,
+   after T's priority has changed, so that the queues stay sorted.
+   T may be sleeping in sema_down(), in cond_wait(), or both. */
+void
+synch_requeue (struct thread *t) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (t->blocked_sema != NULL)
+    {
+      list_remove (&t->elem);
+      list_insert_ordered (&t->blocked_sema->waiters, &t->elem,
+                           waiter_greater, NULL);
+    }
+  if (t->blocked_cond != NULL)
+    {
+      list_remove (t->cond_elem);
+      list_insert_ordered (&t->blocked_cond->waiters, t->cond_elem,
+                           sema_elem_greater, NULL);
+    }
+  intr_set_level (old_level);
+}
+
+/* Orders threads in a semaphore's waiters by decreasing
+   priority.  Ties compare false, which keeps insertion FIFO. */
+static bool
+waiter_greater (const struct list_elem *a, const struct list_elem *b,
+                void *aux UNUSED)
+{
+  return list_entry (a, struct thread, elem)->priority
+         > list_entry (b, struct thread, elem)->priority;
+}
+
+/* Orders a condition's waiters by decreasing priority of the
+   waiting thread.  Ties compare false, which keeps insertion
+   FIFO. */
+static bool
+sema_elem_greater (const struct list_elem *a, const struct list_elem *b,
+                   void *aux UNUSED)
+{
+  return list_entry (a, struct semaphore_elem, elem)->thread->priority
+         > list_entry (b, struct semaphore_elem, elem)->thread->priority;
+}
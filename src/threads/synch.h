@@ -46,6 +46,29 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock.  Any number of readers may hold the lock
+   at once, or a single writer.  Writers are preferred: once a
+   writer is waiting, new readers block until it is served. */
+struct rwlock
+  {
+    struct lock lock;           /* Protects the members below. */
+    struct condition read_ok;   /* Signaled when readers may enter. */
+    struct condition write_ok;  /* Signaled when a writer may enter. */
+    unsigned readers;           /* Number of active readers. */
+    unsigned waiting_writers;   /* Number of blocked writers. */
+    struct thread *writer;      /* Active writer, if any. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
+struct thread;
+void synch_requeue (struct thread *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
@@ -13,6 +13,9 @@
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/perf.h"
+#include "threads/trace.h"
+#include "userprog/fdtable.h"
 #include "threads/switch.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
@@ -203,7 +206,13 @@ thread_tick (void)
           int new_priority = PRI_MAX - (p->recent_cpu >> (FRACT_BITS + 2)) - (p->nicess << 1);
           if(new_priority > PRI_MAX) new_priority = PRI_MAX;
           if(new_priority < PRI_MIN) new_priority = PRI_MIN;
-          p->priority = new_priority;
+          if(p->priority != new_priority)
+          {
+            p->priority = new_priority;
+            /* Keep the wait queue it sleeps on sorted */
+            if(p->status == THREAD_BLOCKED)
+              synch_requeue(p);
+          }
         }
     }
     /* Enforce preemption. */
@@ -270,17 +279,8 @@ thread_create (const char *name, int priority,
   sf = alloc_frame (t, sizeof *sf);
   sf->eip = switch_entry;
   sf->ebp = 0;
-  /* Init the file descriptor array */
-  t->ofile = palloc_get_page(0);
-  int i;
-  for (i = 0; i < NOFILE; i++)
-  {
-    t->ofile[i].file = NULL;
-    t->ofile[i].mfile = NULL;
-    t->ofile[i].dir = NULL;
-    t->ofile[i].mmap_start = NULL;
-    t->ofile[i].mmap_end = NULL;
-  }
+  /* Init the file descriptor table, empty until the first open */
+  fd_table_init(&t->fdt);
     /* Init the thread directory */
   if(thread_current()->cur_dir != NULL)
   {
@@ -552,6 +552,11 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Spend the spare cycles zeroing user pages for future page
+         faults.  Only halt once there is nothing left to zero. */
+      if (palloc_refill_zeroed ())
+        continue;
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -647,6 +652,7 @@ init_thread (struct thread *t, const char *name, int priority)
   lock_init(&t->internal_lock);
   lock_init(&t->parrent_lock);
   list_init(&t->childs);
+  list_init(&t->aio_reqs);
   if(t != initial_thread)
   {
     t->parrent = thread_current();
@@ -756,7 +762,11 @@ schedule (void)
   ASSERT (is_thread (next));
 
   if (cur != next)
-    prev = switch_threads (cur, next);
+    {
+      perf_inc (PERF_CONTEXT_SWITCH);
+      trace (TRACE_SWITCH, cur->tid, next->tid);
+      prev = switch_threads (cur, next);
+    }
   thread_schedule_tail (prev);
   // DBG_MSG_THREAD("[%s] get CPU\n", thread_name());
 }
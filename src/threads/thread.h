@@ -7,7 +7,6 @@
 #define THREADS_THREAD_H
 #define USERPROG
 #define DEBUG 0
-#define NOFILE 128
 #include <debug.h>
 #include <list.h>
 #include "hash.h"
@@ -16,6 +15,7 @@
 #include <threads/synch.h>
 #include "filesys/file.h"
 #include "filesys/directory.h"
+#include "threads/perf.h"
 
 /* Debug  */
 #if(DEBUG > 3)
@@ -70,7 +70,16 @@ struct openning_file
   struct dir *dir;
   uint8_t *mmap_start;
   uint8_t *mmap_end;
+  int next_free;                      /* Next free slot, see fdtable.c */
+};
 
+/* Descriptor table of a process, grown on demand */
+struct fd_table
+{
+  struct openning_file *slots;        /* Array of SIZE slots */
+  int size;                           /* Number of allocated slots */
+  int hi;                             /* Slots [0, hi) have been handed out */
+  int free;                           /* First free slot, or -1 */
 };
 
 /* Page management */
@@ -155,11 +164,20 @@ struct thread
     struct thread *parrent;             /* Parrent of this process */
     struct list childs;                 /* Childs of this process */
     struct list_elem child_elem;        /* List element for child */
-    struct openning_file *ofile;
+    struct fd_table fdt;                /* Open file descriptors */
     struct lock internal_lock;          /* My own lock */
     struct lock parrent_lock;           /* My parrent lock */
     int userprog_status;
     struct file *my_elf;
+    void *fault_fixup;                  /* Resume address for a kernel fault
+                                           on user memory, see uaccess.c */
+    struct sys_ring *ring;              /* Registered syscall ring (user
+                                           address, pinned) */
+    char *out_buf;                      /* Line buffer for stdout, or NULL */
+    size_t out_len;                     /* Bytes waiting in out_buf */
+    perf_hist_t *lat_hist;              /* Own latency histograms, or NULL */
+    struct list aio_reqs;               /* Outstanding asynchronous I/O */
+    int aio_next_id;                    /* Identifier for the next one */
 
     /* Used in Project 3 - VM */
     struct page_mgm *page_mgm;
@@ -167,6 +185,7 @@ struct thread
     /* Used in Project 4 - VM */
     struct dir *cur_dir;                /* Process current directory */
     struct dir *workdir;               /* Directory that process works on */
+    int journal_depth;                  /* Nesting of journal_begin() calls. */
 #endif
 
     /* Owned by thread.c. */
@@ -178,6 +197,9 @@ struct thread
     struct list_elem wait_elem;         /* List elemen for waiting list */
     struct list waiters;                /* List of thread wating for this thread */   
     struct thread *waitee;              /* Thread that this thread is waiting for*/
+    struct semaphore *blocked_sema;     /* Semaphore this thread sleeps on */
+    struct condition *blocked_cond;     /* Condition this thread waits on */
+    struct list_elem *cond_elem;        /* Its entry in blocked_cond waiters */
     /* Member for advanced scheduler */
     int nicess;                         /* Nice value */
     int recent_cpu;                     /* Recent CPU */
@@ -0,0 +1,148 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/perf.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Event tracing.
+
+   Events are appended to a ring of fixed-size binary records,
+   overwriting the oldest once it fills.  Logging a record takes
+   a few dozen instructions with interrupts off and never touches
+   the console, so tracing barely changes the timing of what it
+   records, unlike the DBG_MSG_* macros.  The "trace" action
+   saves the ring to a file that "pintos -g" can fetch, and
+   utils/pintos-trace turns that into a timeline. */
+
+/* Size of the ring. */
+#define TRACE_PAGES 24
+#define TRACE_RECORDS (TRACE_PAGES * PGSIZE / sizeof (struct trace_record))
+
+bool trace_on;
+
+static struct trace_record *ring;       /* Allocated on first start. */
+static size_t logged_cnt;               /* Records logged in all. */
+
+/* Time-stamp counter and timer ticks when tracing first started,
+   for estimating the counter's rate. */
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+static void make_header (struct trace_header *);
+
+/* Starts tracing, allocating the ring the first time.  Returns
+   false if out of memory. */
+bool
+trace_start (void) 
+{
+  if (ring == NULL) 
+    {
+      ring = palloc_get_multiple (PAL_ZERO, TRACE_PAGES);
+      if (ring == NULL)
+        return false;
+      start_tsc = rdtsc ();
+      start_ticks = timer_ticks ();
+    }
+  trace_on = true;
+  return true;
+}
+
+/* Stops tracing.  The records logged so far are kept. */
+void
+trace_stop (void) 
+{
+  trace_on = false;
+}
+
+/* Appends a record of EVENT with ARG0 and ARG1 to the ring.
+   Callable from interrupt handlers. */
+void
+trace_log (enum trace_event event, uint32_t arg0, uint32_t arg1) 
+{
+  struct thread *t;
+  struct trace_record *r;
+  enum intr_level old_level;
+  uint32_t *esp;
+
+  /* Find the running thread the way running_thread() does:
+     thread_current() would assert while a switch is under way. */
+  asm ("mov %%esp, %0" : "=g" (esp));
+  t = pg_round_down (esp);
+
+  old_level = intr_disable ();
+  r = &ring[logged_cnt++ % TRACE_RECORDS];
+  r->tsc = rdtsc ();
+  r->event = event;
+  r->tid = t->tid;
+  r->arg0 = arg0;
+  r->arg1 = arg1;
+  intr_set_level (old_level);
+}
+
+/* Returns the number of bytes in the trace as trace_read()
+   presents it. */
+size_t
+trace_size (void) 
+{
+  size_t cnt = logged_cnt < TRACE_RECORDS ? logged_cnt : TRACE_RECORDS;
+  return sizeof (struct trace_header) + cnt * sizeof (struct trace_record);
+}
+
+/* Copies up to SIZE bytes of the trace, starting at byte offset
+   OFS, into BUFFER, and returns the number of bytes copied.  The
+   trace is a struct trace_header followed by the records still in
+   the ring, oldest first.  Tracing should be stopped while the
+   trace is read, or the ring may move underneath. */
+size_t
+trace_read (size_t ofs, void *buffer_, size_t size) 
+{
+  uint8_t *buffer = buffer_;
+  size_t total = trace_size ();
+  size_t first = logged_cnt - (total - sizeof (struct trace_header))
+                              / sizeof (struct trace_record);
+  size_t copied = 0;
+
+  while (copied < size && ofs < total) 
+    {
+      const uint8_t *src;
+      size_t chunk;
+
+      if (ofs < sizeof (struct trace_header))
+        {
+          static struct trace_header header;
+          make_header (&header);
+          src = (const uint8_t *) &header + ofs;
+          chunk = sizeof header - ofs;
+        }
+      else
+        {
+          size_t rec_ofs = ofs - sizeof (struct trace_header);
+          size_t idx = (first + rec_ofs / sizeof *ring) % TRACE_RECORDS;
+          src = (const uint8_t *) &ring[idx] + rec_ofs % sizeof *ring;
+          chunk = sizeof *ring - rec_ofs % sizeof *ring;
+        }
+      if (chunk > size - copied)
+        chunk = size - copied;
+      memcpy (buffer + copied, src, chunk);
+      copied += chunk;
+      ofs += chunk;
+    }
+  return copied;
+}
+
+/* Fills in *H to describe the current contents of the ring. */
+static void
+make_header (struct trace_header *h) 
+{
+  int64_t ticks = timer_ticks () - start_ticks;
+
+  memcpy (h->magic, "PTRC", 4);
+  h->version = TRACE_VERSION;
+  h->record_size = sizeof (struct trace_record);
+  h->record_cnt = ((trace_size () - sizeof *h) / sizeof (struct trace_record));
+  h->tsc_per_sec = ticks > 0 ? (rdtsc () - start_tsc) * TIMER_FREQ / ticks : 0;
+}
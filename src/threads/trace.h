@@ -0,0 +1,79 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Kinds of traced events.  ARG0 and ARG1 of each record mean:
+
+     TRACE_SWITCH        tid switched from, tid switched to.
+     TRACE_LOCK_WAIT     lock address, tid of its holder.
+     TRACE_LOCK_ACQUIRE  lock address, 0 (after a TRACE_LOCK_WAIT).
+     TRACE_CACHE_LOAD    sector loaded, 1 if it was read from disk.
+     TRACE_CACHE_EVICT   sector evicted, 1 if it was dirty.
+     TRACE_FRAME_ALLOC   user page, kernel page.
+     TRACE_FRAME_EVICT   user page evicted, tid of its owner.
+     TRACE_SWAP_IN       swap slot, kernel page.
+     TRACE_SWAP_OUT      swap slot, tid of the page's owner.
+     TRACE_BLOCK_READ    sector, block device type.
+     TRACE_BLOCK_WRITE   sector, block device type.
+
+   utils/pintos-trace must be kept in step with this list. */
+enum trace_event
+  {
+    TRACE_SWITCH,
+    TRACE_LOCK_WAIT,
+    TRACE_LOCK_ACQUIRE,
+    TRACE_CACHE_LOAD,
+    TRACE_CACHE_EVICT,
+    TRACE_FRAME_ALLOC,
+    TRACE_FRAME_EVICT,
+    TRACE_SWAP_IN,
+    TRACE_SWAP_OUT,
+    TRACE_BLOCK_READ,
+    TRACE_BLOCK_WRITE
+  };
+
+/* A trace record. */
+struct trace_record
+  {
+    uint64_t tsc;               /* Time-stamp counter. */
+    uint16_t event;             /* A TRACE_* value. */
+    uint16_t tid;               /* Thread running at the time. */
+    uint32_t arg0;              /* First argument. */
+    uint32_t arg1;              /* Second argument. */
+    uint32_t pad;               /* Unused; keeps records 8-aligned. */
+  };
+
+/* Trace file header, followed by the records oldest first. */
+struct trace_header
+  {
+    char magic[4];              /* "PTRC". */
+    uint32_t version;           /* TRACE_VERSION. */
+    uint32_t record_size;       /* sizeof (struct trace_record). */
+    uint32_t record_cnt;        /* Number of records that follow. */
+    uint64_t tsc_per_sec;       /* Estimated time-stamp counter rate. */
+  };
+
+#define TRACE_VERSION 1
+
+/* True while tracing.  Test it before computing arguments that
+   are expensive to get. */
+extern bool trace_on;
+
+bool trace_start (void);
+void trace_stop (void);
+void trace_log (enum trace_event, uint32_t arg0, uint32_t arg1);
+size_t trace_size (void);
+size_t trace_read (size_t ofs, void *buffer, size_t size);
+
+/* Records EVENT with ARG0 and ARG1, if tracing. */
+static inline void
+trace (enum trace_event event, uint32_t arg0, uint32_t arg1) 
+{
+  if (trace_on)
+    trace_log (event, arg0, arg1);
+}
+
+#endif /* threads/trace.h */
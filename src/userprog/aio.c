@@ -0,0 +1,263 @@
+#include "userprog/aio.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/uaccess.h"
+#include "vm/frame.h"
+
+/* Asynchronous file I/O.
+
+   A request names an inode, a file offset and a user buffer.
+   The system call layer pins the buffer before submitting, and
+   the request records the kernel address of every pinned page,
+   so a worker thread can move the data with inode_read_at() or
+   inode_write_at() without running in the process's address
+   space.  The owning process reaps each request with aio_wait(),
+   which unpins the buffer; requests still outstanding when it
+   exits are waited for in aio_exit(). */
+
+/* Number of kernel I/O threads. */
+#define AIO_WORKERS 4
+
+/* Pages one request's buffer may touch. */
+#define AIO_MAX_PAGES (AIO_MAX_LEN / PGSIZE + 1)
+
+/* Outstanding requests may keep at most 1/AIO_PIN_SHARE of the
+   user frames pinned, so that eviction always has frames left to
+   choose from. */
+#define AIO_PIN_SHARE 4
+
+extern struct _frame frame;
+
+/* An asynchronous read or write. */
+struct aio_request
+  {
+    struct list_elem elem;              /* Element in aio_queue. */
+    struct list_elem proc_elem;         /* Element in owner's aio_reqs. */
+    int id;                             /* Identifier given to the owner. */
+    bool write;                         /* Write rather than read? */
+    struct inode *inode;                /* Inode, reopened for the request. */
+    off_t offset;                       /* File offset. */
+    uint8_t *ubuf;                      /* User buffer, pinned. */
+    size_t len;                         /* Buffer length. */
+    uint8_t *kpages[AIO_MAX_PAGES];     /* Kernel addresses of its pages. */
+    size_t page_cnt;                    /* Number of pages in KPAGES. */
+    int result;                         /* Bytes transferred, once done. */
+    bool complete;                      /* Has a worker finished it? */
+    struct semaphore done;              /* Upped on completion. */
+  };
+
+static struct list aio_queue;           /* Requests not yet started. */
+static struct lock aio_lock;            /* Protects aio_queue, aio_pinned. */
+static size_t aio_pinned;               /* Pages pinned by all requests. */
+static struct semaphore aio_pending;    /* Counts requests in aio_queue. */
+
+static thread_func aio_worker NO_RETURN;
+static int aio_run (struct aio_request *);
+static struct aio_request *aio_find (int id);
+static int aio_reap (struct aio_request *);
+
+/* Starts the I/O worker threads. */
+void
+aio_init (void) 
+{
+  int i;
+
+  list_init (&aio_queue);
+  lock_init (&aio_lock);
+  sema_init (&aio_pending, 0);
+  for (i = 0; i < AIO_WORKERS; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "aio-%d", i);
+      thread_create (name, PRI_DEFAULT, aio_worker, NULL);
+    }
+}
+
+/* Queues a transfer of LEN bytes between INODE at OFFSET and user
+   buffer UBUF, a write to the inode if WRITE.  UBUF must already
+   be pinned with uaccess_pin(); it stays pinned until the request
+   is reaped.  Returns the request's identifier, or -1 if the
+   request is too long, the process has too many outstanding, or
+   outstanding requests already pin too much memory. */
+int
+aio_submit (struct inode *inode, void *ubuf, size_t len, off_t offset,
+            bool write) 
+{
+  struct thread *cur = thread_current ();
+  struct aio_request *r;
+  uint8_t *page;
+  size_t page_cnt;
+  size_t i;
+
+  if (len > AIO_MAX_LEN || list_size (&cur->aio_reqs) >= AIO_MAX_REQUESTS)
+    return -1;
+  page_cnt = 0;
+  if (len > 0)
+    page_cnt = pg_no ((uint8_t *) ubuf + len - 1) - pg_no (ubuf) + 1;
+  r = malloc (sizeof *r);
+  if (r == NULL)
+    return -1;
+
+  lock_acquire (&aio_lock);
+  if (aio_pinned + page_cnt > frame.user_frames / AIO_PIN_SHARE)
+    {
+      lock_release (&aio_lock);
+      free (r);
+      return -1;
+    }
+  aio_pinned += page_cnt;
+  lock_release (&aio_lock);
+
+  r->id = cur->aio_next_id++;
+  r->write = write;
+  r->inode = inode_reopen (inode);
+  r->offset = offset;
+  r->ubuf = ubuf;
+  r->len = len;
+  r->page_cnt = page_cnt;
+  r->result = 0;
+  r->complete = false;
+  sema_init (&r->done, 0);
+  for (i = 0, page = pg_round_down (ubuf); page < r->ubuf + len;
+       i++, page += PGSIZE)
+    {
+      r->kpages[i] = pagedir_get_page (cur->pagedir, page);
+      ASSERT (r->kpages[i] != NULL);
+    }
+  list_push_back (&cur->aio_reqs, &r->proc_elem);
+
+  lock_acquire (&aio_lock);
+  list_push_back (&aio_queue, &r->elem);
+  lock_release (&aio_lock);
+  sema_up (&aio_pending);
+  return r->id;
+}
+
+/* Returns 1 if request ID of the current process has completed,
+   0 if it is still in progress, or -1 if there is no such
+   request. */
+int
+aio_poll (int id) 
+{
+  struct aio_request *r = aio_find (id);
+  if (r == NULL)
+    return -1;
+  return r->complete ? 1 : 0;
+}
+
+/* Waits for request ID of the current process to complete, then
+   releases it and returns the number of bytes it transferred.
+   Returns -1 if there is no such request. */
+int
+aio_wait (int id) 
+{
+  struct aio_request *r = aio_find (id);
+  if (r == NULL)
+    return -1;
+  return aio_reap (r);
+}
+
+/* Waits for and releases every request of the current process.
+   Called on process exit, before its pages are freed. */
+void
+aio_exit (void) 
+{
+  struct thread *cur = thread_current ();
+
+  while (!list_empty (&cur->aio_reqs))
+    aio_reap (list_entry (list_front (&cur->aio_reqs),
+                          struct aio_request, proc_elem));
+}
+
+/* Returns the current process's request ID, or a null pointer. */
+static struct aio_request *
+aio_find (int id) 
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->aio_reqs); e != list_end (&cur->aio_reqs);
+       e = list_next (e))
+    {
+      struct aio_request *r = list_entry (e, struct aio_request, proc_elem);
+      if (r->id == id)
+        return r;
+    }
+  return NULL;
+}
+
+/* Waits for R to complete, unpins its buffer, frees it and
+   returns its result. */
+static int
+aio_reap (struct aio_request *r) 
+{
+  int result;
+
+  sema_down (&r->done);
+  list_remove (&r->proc_elem);
+  uaccess_unpin (r->ubuf, r->len);
+  lock_acquire (&aio_lock);
+  aio_pinned -= r->page_cnt;
+  lock_release (&aio_lock);
+  inode_close (r->inode);
+  result = r->result;
+  free (r);
+  return result;
+}
+
+/* An I/O worker: runs queued requests forever. */
+static void
+aio_worker (void *aux UNUSED) 
+{
+  for (;;) 
+    {
+      struct aio_request *r;
+
+      sema_down (&aio_pending);
+      lock_acquire (&aio_lock);
+      r = list_entry (list_pop_front (&aio_queue), struct aio_request, elem);
+      lock_release (&aio_lock);
+
+      r->result = aio_run (r);
+      r->complete = true;
+      sema_up (&r->done);
+    }
+}
+
+/* Performs R's transfer a page at a time through the kernel
+   addresses of its pinned pages.  Returns the number of bytes
+   transferred, short at end of file. */
+static int
+aio_run (struct aio_request *r) 
+{
+  size_t done = 0;
+
+  while (done < r->len) 
+    {
+      uint8_t *uaddr = r->ubuf + done;
+      size_t page_idx = pg_no (uaddr) - pg_no (r->ubuf);
+      size_t page_left = PGSIZE - pg_ofs (uaddr);
+      size_t chunk = r->len - done < page_left ? r->len - done : page_left;
+      uint8_t *kaddr = r->kpages[page_idx] + pg_ofs (uaddr);
+      off_t n;
+
+      if (r->write)
+        n = inode_write_at (r->inode, kaddr, chunk, r->offset + done);
+      else if (r->offset + (off_t) done < inode_length (r->inode))
+        n = inode_read_at (r->inode, kaddr, chunk, r->offset + done);
+      else
+        break;
+      done += n;
+      if ((size_t) n < chunk)
+        break;
+    }
+  return done;
+}
@@ -0,0 +1,23 @@
+#ifndef USERPROG_AIO_H
+#define USERPROG_AIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+/* Longest transfer one asynchronous request may carry. */
+#define AIO_MAX_LEN (64 * 1024)
+
+/* Most requests one process may have outstanding. */
+#define AIO_MAX_REQUESTS 32
+
+struct inode;
+
+void aio_init (void);
+int aio_submit (struct inode *, void *ubuf, size_t len, off_t offset,
+                bool write);
+int aio_poll (int id);
+int aio_wait (int id);
+void aio_exit (void);
+
+#endif /* userprog/aio.h */
@@ -0,0 +1,141 @@
+#include "userprog/elfcache.h"
+#include <debug.h>
+#include <stddef.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/synch.h"
+
+/* Cache of parsed executables.
+
+   Spawning the same program over and over would otherwise read
+   and validate its ELF header and program headers from disk on
+   every exec.  An entry keeps its inode open, so the in-memory
+   inode and its write generation stay meaningful; any write to
+   the file since the entry was made makes the entry stale.
+   Removing the file drops its entry at once, so that the
+   reference does not keep its sectors allocated.  Entries are
+   replaced least recently used first.
+
+   Inodes are closed only after elf_cache_lock is released, since
+   closing one may start a file system operation, and
+   elf_cache_forget() takes the lock in the middle of one. */
+
+/* Number of executables cached. */
+#define ELF_CACHE_SIZE 8
+
+struct elf_cache_entry
+  {
+    struct inode *inode;        /* Executable, or null if unused. */
+    unsigned write_gen;         /* inode_write_gen() when parsed. */
+    unsigned last_use;          /* Value of use_clock at last use. */
+    struct elf_image image;     /* Parsed headers. */
+  };
+
+static struct elf_cache_entry elf_cache[ELF_CACHE_SIZE];
+static struct lock elf_cache_lock;
+static unsigned use_clock;
+
+static struct inode *entry_drop (struct elf_cache_entry *);
+static void elf_cache_forget (struct inode *);
+
+/* Initializes the executable cache. */
+void
+elf_cache_init (void) 
+{
+  lock_init (&elf_cache_lock);
+  inode_set_remove_hook (elf_cache_forget);
+}
+
+/* If FILE's headers are cached and still current, copies them
+   into *IMAGE and returns true.  Otherwise returns false. */
+bool
+elf_cache_lookup (struct file *file, struct elf_image *image) 
+{
+  struct inode *inode = file_get_inode (file);
+  struct inode *stale = NULL;
+  bool found = false;
+  int i;
+
+  lock_acquire (&elf_cache_lock);
+  for (i = 0; i < ELF_CACHE_SIZE; i++)
+    {
+      struct elf_cache_entry *e = &elf_cache[i];
+      if (e->inode != inode)
+        continue;
+      if (e->write_gen != inode_write_gen (inode) || inode_is_removed (inode))
+        stale = entry_drop (e);
+      else
+        {
+          e->last_use = ++use_clock;
+          *image = e->image;
+          found = true;
+        }
+      break;
+    }
+  lock_release (&elf_cache_lock);
+  inode_close (stale);
+  return found;
+}
+
+/* Records IMAGE as the parsed headers of FILE, replacing the
+   least recently used entry if the cache is full. */
+void
+elf_cache_insert (struct file *file, const struct elf_image *image) 
+{
+  struct inode *inode = file_get_inode (file);
+  struct elf_cache_entry *victim = NULL;
+  struct inode *old = NULL;
+  int i;
+
+  lock_acquire (&elf_cache_lock);
+  for (i = 0; i < ELF_CACHE_SIZE; i++)
+    {
+      struct elf_cache_entry *e = &elf_cache[i];
+      if (e->inode == inode || e->inode == NULL)
+        {
+          victim = e;
+          break;
+        }
+      if (victim == NULL || e->last_use < victim->last_use)
+        victim = e;
+    }
+  if (victim->inode != NULL)
+    old = entry_drop (victim);
+  victim->inode = inode_reopen (inode);
+  victim->write_gen = inode_write_gen (inode);
+  victim->last_use = ++use_clock;
+  victim->image = *image;
+  lock_release (&elf_cache_lock);
+  inode_close (old);
+}
+
+/* Drops the entry for INODE, if any, because INODE has been
+   removed.  Called by inode_remove(). */
+static void
+elf_cache_forget (struct inode *inode) 
+{
+  struct inode *old = NULL;
+  int i;
+
+  lock_acquire (&elf_cache_lock);
+  for (i = 0; i < ELF_CACHE_SIZE; i++)
+    if (elf_cache[i].inode == inode)
+      {
+        old = entry_drop (&elf_cache[i]);
+        break;
+      }
+  lock_release (&elf_cache_lock);
+  inode_close (old);
+}
+
+/* Empties cache entry E and returns the inode it held, which the
+   caller must close once it has released elf_cache_lock. */
+static struct inode *
+entry_drop (struct elf_cache_entry *e) 
+{
+  struct inode *inode = e->inode;
+
+  ASSERT (inode != NULL);
+  e->inode = NULL;
+  return inode;
+}
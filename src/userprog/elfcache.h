@@ -0,0 +1,35 @@
+#ifndef USERPROG_ELFCACHE_H
+#define USERPROG_ELFCACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct file;
+
+/* Most loadable segments an executable may have. */
+#define ELF_MAX_SEGMENTS 16
+
+/* A loadable segment, already validated and reduced to what
+   load_segment() needs. */
+struct elf_segment
+  {
+    uint32_t file_page;         /* Page-aligned offset in the file. */
+    uint32_t mem_page;          /* Page-aligned user virtual address. */
+    uint32_t read_bytes;        /* Bytes to read from the file. */
+    uint32_t zero_bytes;        /* Bytes to zero after them. */
+    bool writable;              /* Writable by the process? */
+  };
+
+/* The parsed ELF headers of an executable. */
+struct elf_image
+  {
+    uint32_t entry;                             /* Entry point. */
+    int seg_cnt;                                /* Number of segments. */
+    struct elf_segment segs[ELF_MAX_SEGMENTS];  /* Loadable segments. */
+  };
+
+void elf_cache_init (void);
+bool elf_cache_lookup (struct file *, struct elf_image *);
+void elf_cache_insert (struct file *, const struct elf_image *);
+
+#endif /* userprog/elfcache.h */
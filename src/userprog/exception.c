@@ -5,12 +5,14 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "string.h"
+#include "userprog/fdtable.h"
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/palloc.h"
+#include "threads/perf.h"
 #include "threads/pte.h"
 #include "process.h"
 #include "vm/frame.h"
@@ -21,6 +23,7 @@
 static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
+static void bad_access (struct intr_frame *, bool user);
 static void page_fault (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
@@ -124,6 +127,24 @@ kill (struct intr_frame *f)
     }
 }
 
+/* Handles a page fault that cannot be resolved.  If the kernel
+   faulted while copying to or from user memory with a fixup
+   armed (see userprog/uaccess.c), resumes at the fixup so the
+   copy reports failure to its caller.  Otherwise kills the
+   process. */
+static void
+bad_access (struct intr_frame *f, bool user) 
+{
+  struct thread *t = thread_current ();
+  if (!user && t->fault_fixup != NULL)
+    {
+      f->eip = t->fault_fixup;
+      t->fault_fixup = NULL;
+      return;
+    }
+  kill (f);
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to project 2 may
    also require modifying this code.
@@ -150,6 +171,8 @@ page_fault (struct intr_frame *f)
      See [IA32-v2a] "MOV--Move to/from Control Registers" and
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
+  uint64_t start = rdtsc ();
+  int kind = -1;     /* PERF_PF_* counter for the latency histogram */
   asm ("movl %%cr2, %0" : "=r" (fault_addr));
 //   DBG_MSG_USERPROG("[%s] call page fault at 0x%x\n", thread_name(), fault_addr);
   /* Turn interrupts back on (they were only off so that we could
@@ -166,11 +189,13 @@ page_fault (struct intr_frame *f)
   uint8_t *vpage = (uint8_t *) ROUND_DOWN((uint32_t) fault_addr, PGSIZE);
   if(fault_addr == NULL || vpage >= PHYS_BASE) /* Illegal address */
   {
-      kill(f);
+      bad_access(f, user);
+      return;
   }
   if(write && !not_present) /* Write violation */
   {
-     kill(f);
+     bad_access(f, user);
+     return;
   }
   struct page *p = page_table_lookup(thread_current(), vpage);
   if(p != NULL)
@@ -183,6 +208,7 @@ page_fault (struct intr_frame *f)
       }
       if(p->aux == -1) /* load new page from elf --> do nothing */
       {
+         kind = PERF_PF_ZERO;
          // DBG_MSG_VM("[VM: %s] load 0x%x from elf %d\n", thread_name(), p->vaddr, p->aux);
          install_page(vpage, kpage, 1);
       }
@@ -190,9 +216,10 @@ page_fault (struct intr_frame *f)
       {
          if((uint32_t) p->vaddr & PTE_AVL) // mmap page
          {
+            kind = PERF_PF_MMAP;
             install_page(vpage, kpage, 1);
             DBG_MSG_VM("[VM: %s] load 0x%x from mmap %d\n", thread_name(), p->vaddr, p->aux);
-            struct openning_file *f = &thread_current()->ofile[(uint32_t) p->aux - 2];
+            struct openning_file *f = fd_lookup(&thread_current()->fdt, (uint32_t) p->aux);
             uint32_t file_offset = vpage - f->mmap_start;
             // read from file
             frame_table_set_restricted(vtop(kpage), -1);
@@ -206,6 +233,7 @@ page_fault (struct intr_frame *f)
          else
          {
             DBG_MSG_VM("[VM: %s] load 0x%x from swap %d at pf %d\n", thread_name(), p->vaddr, (uint32_t) p->aux >> 12, page_fault_cnt);
+            kind = PERF_PF_SWAP;
             /* Mark the frame that's being swapped in */
             frame_table_set_restricted(vtop(kpage), -1);
             swap_in((uint32_t) p->aux >> PGBITS, vtop(kpage));
@@ -227,6 +255,7 @@ page_fault (struct intr_frame *f)
   else if ((fault_addr - f->esp < PGSIZE && f->esp - fault_addr < PGSIZE) ) /* Stack growth */
   {
       DBG_MSG_VM("[VM: %s] stack growth\n", thread_name());
+      kind = PERF_PF_STACK;
       while (vpage < PHYS_BASE)
       {
          if(pagedir_get_page(thread_current()->pagedir ,vpage) == NULL)
@@ -249,10 +278,13 @@ page_fault (struct intr_frame *f)
       DBG_MSG_VM("[VM: %s] call page fault at 0x%x at pf %d\n", thread_name(), fault_addr, page_fault_cnt);  
       // intr_dump_frame(f);
       // PANIC("PGF");
-      kill(f);
+      bad_access(f, user);
+      return;
   }
 
   done:
+   perf_inc(kind);
+   perf_lat_record(PERF_LAT_FAULT_BASE + kind - PERF_PF_ZERO, start);
    return;
 }
 
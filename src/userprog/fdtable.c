@@ -0,0 +1,134 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+
+/* Number of slots in a table's first allocation. */
+#define FD_TABLE_MIN 8
+
+/* next_free of a slot that is not on the free list. */
+#define FD_IN_USE (-2)
+
+/* Returns true if slot F holds nothing, not even a mapping whose
+   descriptor has already been closed. */
+static bool
+slot_is_empty (const struct openning_file *f) 
+{
+  return f->file == NULL && f->dir == NULL && f->mfile == NULL;
+}
+
+/* Initializes T as an empty table.  No memory is allocated until
+   the first descriptor is opened. */
+void
+fd_table_init (struct fd_table *t) 
+{
+  t->slots = NULL;
+  t->size = 0;
+  t->hi = 0;
+  t->free = -1;
+}
+
+/* Frees T's slots.  The caller must already have closed what
+   they refer to. */
+void
+fd_table_destroy (struct fd_table *t) 
+{
+  free (t->slots);
+  fd_table_init (t);
+}
+
+/* Reserves a slot in T and returns its descriptor, or -1 if the
+   table cannot grow.  Freed slots are reused first, most
+   recently freed first, so allocation is O(1) apart from the
+   occasional doubling of the table. */
+int
+fd_alloc (struct fd_table *t) 
+{
+  struct openning_file *f;
+  int slot;
+
+  if (t->free != -1)
+    {
+      slot = t->free;
+      t->free = t->slots[slot].next_free;
+    }
+  else
+    {
+      if (t->hi == t->size)
+        {
+          int size = t->size == 0 ? FD_TABLE_MIN : t->size * 2;
+          struct openning_file *slots = realloc (t->slots,
+                                                 size * sizeof *slots);
+          if (slots == NULL)
+            return -1;
+          t->slots = slots;
+          t->size = size;
+        }
+      slot = t->hi++;
+    }
+  f = &t->slots[slot];
+  memset (f, 0, sizeof *f);
+  f->next_free = FD_IN_USE;
+  return slot + FD_BASE;
+}
+
+/* Returns the slot for descriptor FD in T, or a null pointer if
+   FD has never been handed out or its slot is free. */
+struct openning_file *
+fd_lookup (struct fd_table *t, int fd) 
+{
+  struct openning_file *f;
+
+  if (fd < FD_BASE || fd - FD_BASE >= t->hi)
+    return NULL;
+  f = &t->slots[fd - FD_BASE];
+  return slot_is_empty (f) ? NULL : f;
+}
+
+/* Makes descriptor FD, just reserved with fd_alloc(), refer to
+   FILE, which is an open directory if IS_DIR.  filesys_open()
+   returns a directory in place of a file, so FILE is then really
+   a struct dir. */
+void
+fd_install (struct fd_table *t, int fd, struct file *file, bool is_dir) 
+{
+  struct openning_file *f;
+
+  ASSERT (fd >= FD_BASE && fd - FD_BASE < t->hi);
+  f = &t->slots[fd - FD_BASE];
+  ASSERT (slot_is_empty (f) && f->next_free == FD_IN_USE);
+  if (is_dir)
+    f->dir = (struct dir *) file;
+  else
+    f->file = file;
+}
+
+/* Returns FD's slot in T to the free list once nothing in it is
+   open any more.  A slot whose file is closed but still mapped
+   stays reserved until munmap() releases it again. */
+void
+fd_release (struct fd_table *t, int fd) 
+{
+  struct openning_file *f;
+
+  ASSERT (fd >= FD_BASE && fd - FD_BASE < t->hi);
+  f = &t->slots[fd - FD_BASE];
+  if (!slot_is_empty (f) || f->next_free != FD_IN_USE)
+    return;
+  f->next_free = t->free;
+  t->free = fd - FD_BASE;
+}
+
+/* Returns the first descriptor after FD that is in use in T, or
+   -1 if there is none.  Start with FD_BASE - 1 to visit every
+   open descriptor. */
+int
+fd_next (struct fd_table *t, int fd) 
+{
+  int slot;
+
+  for (slot = fd - FD_BASE + 1; slot < t->hi; slot++)
+    if (!slot_is_empty (&t->slots[slot]))
+      return slot + FD_BASE;
+  return -1;
+}
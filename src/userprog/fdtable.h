@@ -0,0 +1,18 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include "threads/thread.h"
+
+/* File descriptors 0 and 1 are the console; slot I of a
+   descriptor table holds descriptor I + FD_BASE. */
+#define FD_BASE 2
+
+void fd_table_init (struct fd_table *);
+void fd_table_destroy (struct fd_table *);
+int fd_alloc (struct fd_table *);
+struct openning_file *fd_lookup (struct fd_table *, int fd);
+void fd_install (struct fd_table *, int fd, struct file *, bool is_dir);
+void fd_release (struct fd_table *, int fd);
+int fd_next (struct fd_table *, int fd);
+
+#endif /* userprog/fdtable.h */
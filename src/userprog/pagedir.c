@@ -47,6 +47,34 @@ pagedir_destroy (uint32_t *pd)
   palloc_free_page (pd);
 }
 
+/* Calls ACTION with each user page mapped in PD, its kernel
+   virtual address, and AUX.  Only page tables that are present
+   are visited, so the cost follows the size of the process
+   rather than of its address space. */
+void
+pagedir_for_each (uint32_t *pd,
+                  void (*action) (void *upage, void *kpage, void *aux),
+                  void *aux) 
+{
+  uint32_t *pde;
+
+  ASSERT (pd != NULL);
+  for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
+    if (*pde & PTE_P) 
+      {
+        uint32_t *pt = pde_get_pt (*pde);
+        uint32_t *pte;
+        
+        for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
+          if (*pte & PTE_P) 
+            {
+              void *upage = (void *) (((pde - pd) << PDSHIFT)
+                                      | ((pte - pt) << PTSHIFT));
+              action (upage, pte_get_page (*pte), aux);
+            }
+      }
+}
+
 /* Returns the address of the page table entry for virtual
    address VADDR in page directory PD.
    If PD does not have a page table for VADDR, behavior depends
@@ -168,6 +196,15 @@ pagedir_is_dirty (uint32_t *pd, const void *vpage)
   return pte != NULL && (*pte & PTE_D) != 0;
 }
 
+/* Returns true if the PTE for virtual page VPAGE in PD is
+   present and writable. */
+bool
+pagedir_is_writable (uint32_t *pd, const void *vpage) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_W)) == (PTE_P | PTE_W);
+}
+
 /* Set the dirty bit to DIRTY in the PTE for virtual page VPAGE
    in PD. */
 void
@@ -10,8 +10,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/aio.h"
+#include "userprog/elfcache.h"
+#include "userprog/fdtable.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
@@ -19,6 +23,7 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
@@ -30,7 +35,6 @@
 extern struct _frame frame;
 extern struct _swap swap;
 static thread_func start_process NO_RETURN;
-static bool load (const char *cmdline, void (**eip) (void), void **esp);
 
 struct execution
 {
@@ -41,6 +45,10 @@ struct execution
   int load_status;
 };
 
+static bool load (const char *cmdline, void (**eip) (void), void **esp,
+                  struct execution *ex);
+static void exec_signal (struct execution *ex, bool success);
+
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
    before process_execute() returns.  Returns the new process's
@@ -108,15 +116,8 @@ start_process (void *thread_args_)
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
   DBG_MSG_USERPROG("[%s] loading userprog %s\n", thread_name(), file_name);
-  success = load (file_name, &if_.eip, &if_.esp);
-  /* Now we know that the exec is success or not, so signal the parrent */
-  /* If load failed, quit. --> parrent will free args, relax */
-  thread_args->load_status = success;
-  DBG_MSG_USERPROG("[%s] signaling my parrent %s...\n", thread_name(), thread_current()->parrent->name);
-  lock_acquire(&thread_args->ex_lock);
-  cond_signal(&thread_args->ex_cond, &thread_args->ex_lock);
-  lock_release(&thread_args->ex_lock);
-  DBG_MSG_USERPROG("[%s] signaling OK...\n", thread_name());
+  /* load() signals the parrent once the image is validated */
+  success = load (file_name, &if_.eip, &if_.esp, thread_args);
   if (!success){
     thread_exit ();
   }
@@ -130,6 +131,20 @@ start_process (void *thread_args_)
   NOT_REACHED ();
 }
 
+/* Tells the parrent waiting in process_execute() whether the
+   child could load its executable.  EX must not be touched
+   afterwards: the parrent frees it. */
+static void
+exec_signal (struct execution *ex, bool success)
+{
+  ex->load_status = success;
+  DBG_MSG_USERPROG("[%s] signaling my parrent %s...\n", thread_name(), thread_current()->parrent->name);
+  lock_acquire(&ex->ex_lock);
+  cond_signal(&ex->ex_cond, &ex->ex_lock);
+  lock_release(&ex->ex_lock);
+  DBG_MSG_USERPROG("[%s] signaling OK...\n", thread_name());
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -185,29 +200,44 @@ process_exit (void)
 {
   struct thread *cur = thread_current ();
   uint32_t *pd;
-  /* Unmap all file */
-  uint32_t i;
-  for(i = 0; i < NOFILE; ++i)
+  /* Let in-flight asynchronous I/O finish with our pages */
+  aio_exit();
+  /* Buffered console output goes out before we are gone */
+  stdout_flush();
+  free(cur->out_buf);
+  cur->out_buf = NULL;
+  perf_lat_exit();
+  /* Unmap and close all open descriptors */
+  int fd = FD_BASE - 1;
+  while((fd = fd_next(&cur->fdt, fd)) != -1)
   {
-    if(cur->ofile[i].mfile != NULL) // not yet unmap
+    struct openning_file *f = fd_lookup(&cur->fdt, fd);
+    if(f->mfile != NULL) // not yet unmap
+    {
+      munmap(fd);
+    }
+    if(f->dir != NULL)
     {
-      munmap(i + 2);
+      dir_close(f->dir);
+      f->dir = NULL;
     }
-    if(cur->ofile[i].dir != NULL)
+    if(f->file != NULL)
     {
-      dir_close(cur->ofile[i].dir);
+      file_close(f->file);
+      f->file = NULL;
     }
   }
+  fd_table_destroy(&cur->fdt);
   dir_close(cur->cur_dir);
 
+  /* Only this process's pages are visited below */
   lock_acquire(&frame.lock);
   lock_acquire(&swap.lock);
-  /* Free the swap table */
+  /* Free the swap slots recorded in the supplemental table */
   swap_free(cur);
-  /* Free the frame table */
+  lock_release(&swap.lock);
+  /* Free the frame table entries of the mapped pages */
   frame_table_free(cur);
-  /* Free the supplemental table */
-  page_table_destroy(cur);
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -225,7 +255,9 @@ process_exit (void)
       pagedir_destroy (pd);
     }
   lock_release(&frame.lock);
-  lock_release(&swap.lock);
+  /* No frame is ours any more, so eviction cannot touch the
+     supplemental table now */
+  page_table_destroy(cur);
 }
 
 /* Sets up the CPU for running user code in the current
@@ -308,6 +340,7 @@ struct Elf32_Phdr
 #define PF_R 4          /* Readable. */
 
 static bool setup_stack (void **esp, char **argv, int argc);
+static bool parse_elf (struct file *, struct elf_image *);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
@@ -317,15 +350,19 @@ static int userprog_parser(char *cmd, char **argv);
 /* Loads an ELF executable from FILE_NAME into the current thread.
    Stores the executable's entry point into *EIP
    and its initial stack pointer into *ESP.
+   Signals EX, the parent's exec request, as soon as the
+   executable's headers have been validated, so the parent does
+   not also wait for the segments to load; a failure after that
+   point exits the process with status -1.
    Returns true if successful, false otherwise. */
 
 bool
-load (const char *file_name, void (**eip) (void), void **esp) 
+load (const char *file_name, void (**eip) (void), void **esp,
+      struct execution *ex) 
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
+  struct elf_image image;
   struct file *file = NULL;
-  off_t file_ofs;
   bool success = false;
   int i;
 
@@ -347,9 +384,10 @@ load (const char *file_name, void (**eip) (void), void **esp)
   int attempt = 0;
   while(file == NULL && attempt < 5) /* Busy wait, no way now */
   {
-  file = filesys_open (argv[0]);
-  thread_sleep(10);
-  attempt++;
+    file = filesys_open (argv[0]);
+    if(file == NULL)
+      thread_sleep(10);
+    attempt++;
   }
   if (file == NULL) 
     {
@@ -360,31 +398,86 @@ load (const char *file_name, void (**eip) (void), void **esp)
   file_deny_write(file);
   thread_current()->my_elf = file;
   DBG_MSG_USERPROG("[%s] verify userprog %s\n", thread_name(), argv[0]);
+  /* Parsed headers of a recently run executable can be reused */
+  if (!elf_cache_lookup (file, &image))
+    {
+      if (!parse_elf (file, &image))
+        {
+          printf ("load: %s: error loading executable\n", argv[0]);
+          goto done; 
+        }
+      elf_cache_insert (file, &image);
+    }
+
+  /* The image is valid: let the parent return from exec.  It
+     frees EX, and FILE_NAME with it, once woken. */
+  exec_signal (ex, true);
+  ex = NULL;
+
+  for (i = 0; i < image.seg_cnt; i++)
+    {
+      const struct elf_segment *seg = &image.segs[i];
+      if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+                         seg->read_bytes, seg->zero_bytes, seg->writable))
+        {
+          DBG_MSG_USERPROG("[%s] segment load failed with %s\n",thread_name(), argv[0]);
+          goto done;
+        }
+    }
+
+  /* Set up stack. */
+  DBG_MSG_USERPROG("[%s] set up user stack\n", thread_name());
+  if (!setup_stack (esp, argv, argc))
+    goto done;
+
+  /* Start address. */
+  *eip = (void (*) (void)) image.entry;
+
+  success = true;
+
+ done:
+  /* We arrive here whether the load is successful or not. */
+  palloc_free_page(cmd);
+  // file_close (file);
+  if (ex != NULL)
+    exec_signal (ex, false);
+  else if (!success)
+    exit (-1);
+  return success;
+}
+
+/* Reads and validates FILE's ELF header and program headers and
+   records its loadable segments in *IMAGE.  Returns true if FILE
+   is a loadable executable, false otherwise. */
+static bool
+parse_elf (struct file *file, struct elf_image *image) 
+{
+  struct Elf32_Ehdr ehdr;
+  off_t file_ofs;
+  int i;
+
   /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
       || ehdr.e_type != 2
       || ehdr.e_machine != 3
       || ehdr.e_version != 1
       || ehdr.e_phentsize != sizeof (struct Elf32_Phdr)
       || ehdr.e_phnum > 1024) 
-    {
-      printf ("load: %s: error loading executable\n", argv[0]);
-      goto done; 
-    }
+    return false;
 
   /* Read program headers. */
+  image->entry = ehdr.e_entry;
+  image->seg_cnt = 0;
   file_ofs = ehdr.e_phoff;
   for (i = 0; i < ehdr.e_phnum; i++) 
     {
       struct Elf32_Phdr phdr;
 
       if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
-      file_seek (file, file_ofs);
-
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+        return false;
+      if (file_read_at (file, &phdr, sizeof phdr, file_ofs) != sizeof phdr)
+        return false;
       file_ofs += sizeof phdr;
       switch (phdr.p_type) 
         {
@@ -398,65 +491,45 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          return false;
         case PT_LOAD:
-          if (validate_segment (&phdr, file)) 
+          if (validate_segment (&phdr, file)
+              && image->seg_cnt < ELF_MAX_SEGMENTS) 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
+              struct elf_segment *seg = &image->segs[image->seg_cnt++];
               uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
-              // DBG_MSG_VM("[VM: %s] loading segment %s at user page 0x%x, fsize of 0x%x and msize of 0x%x\n",thread_name(), writable?"data":"code", mem_page, page_offset + phdr.p_filesz, ROUND_UP(phdr.p_memsz, PGSIZE));
+              seg->writable = (phdr.p_flags & PF_W) != 0;
+              seg->file_page = phdr.p_offset & ~PGMASK;
+              seg->mem_page = phdr.p_vaddr & ~PGMASK;
               if (phdr.p_filesz > 0)
                 {
                   /* Normal segment.
                      Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
+                  seg->read_bytes = page_offset + phdr.p_filesz;
+                  seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz,
+                                               PGSIZE)
+                                     - seg->read_bytes);
                 }
               else 
                 {
                   /* Entirely zero.
                      Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+                  seg->read_bytes = 0;
+                  seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz,
+                                              PGSIZE);
                 }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                                 {
-                                    DBG_MSG_USERPROG("[%s] segment load failed with %s\n",thread_name(), file_name);
-                                    goto done;
-                                 }
-              // DBG_MSG_USERPROG("[%s] loading segment %s at upage 0x%x\n",thread_name(), writable?"data":"code", mem_page);
             }
           else
             {
-              DBG_MSG_USERPROG("[%s] segment validate failed with %s\n",thread_name(), file_name);
-              goto done;
+              DBG_MSG_USERPROG("[%s] segment validate failed\n",thread_name());
+              return false;
             }
           break;
         }
     }
-
-  /* Set up stack. */
-  DBG_MSG_USERPROG("[%s] set up user stack\n", thread_name());
-  if (!setup_stack (esp, argv, argc))
-    goto done;
-
-  /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
-
-  success = true;
-
- done:
-  /* We arrive here whether the load is successful or not. */
-  palloc_free_page(cmd);
-  // file_close (file);
-  return success;
+  return true;
 }
-
+
 /* load() helpers. */
 /* TODO: implement userprog_parser */
 static int 
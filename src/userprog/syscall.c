@@ -15,6 +15,9 @@
 #include "lib/kernel/stdio.h"
 #include <string.h>
 #include <userprog/process.h>
+#include "userprog/aio.h"
+#include "userprog/fdtable.h"
+#include "userprog/uaccess.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
 #include "filesys/directory.h"
@@ -23,9 +26,18 @@
 #include "vm/page.h"
 #include "vm/frame.h"
 #include "round.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/perf.h"
+#include "threads/trace.h"
+#include <sysring.h>
 
 
+/* Size of a process's stdout line buffer */
+#define OUT_BUF_SIZE 256
+
 static void syscall_handler (struct intr_frame *);
+static void stdout_write(const char *buffer, size_t length);
 static void halt (void) NO_RETURN;
 static pid_t exec (const char *file);
 static int wait (pid_t);
@@ -44,15 +56,60 @@ static bool mkdir(const char *dir);
 static bool readdir(int id, char *dir);
 static bool isdir(int fd);
 static int inumber(int fd); 
+static int readv (int fd, const struct iovec *iov, int iovcnt);
+static int writev (int fd, const struct iovec *iov, int iovcnt);
+static int pread (int fd, void *buffer, unsigned length, unsigned offset);
+static int pwrite (int fd, const void *buffer, unsigned length,
+                   unsigned offset);
+static int copy_file_range (int fd_in, int fd_out, unsigned length);
+static bool ring_setup (struct sys_ring *ring);
+static int ring_enter (unsigned to_submit);
+static int aio_rw (int fd, void *buffer, unsigned length, unsigned offset,
+                   bool write);
+static int perf_read (unsigned first, unsigned cnt, uint64_t *values);
+static bool perf_hist (unsigned id, bool self, uint32_t *buckets);
 /* File helper */
 static void file_parse(char *file);
+static struct openning_file *fd_entry(int fd);
+static struct file *fd_to_file(int fd);
+static int copy_in_iovec(struct iovec *kiov, const struct iovec *iov,
+                         int iovcnt);
+typedef int xfer_func (void *aux, void *buf, unsigned size, unsigned done);
+static int xfer_pinned(void *buffer, unsigned length, bool write,
+                       xfer_func *xfer, void *aux);
+static int xferv_pinned(struct file *file, const struct iovec *kiov,
+                        int iovcnt, bool read);
+static const char *copy_in_path(char *path, const char *upath);
+
+/* Longest path accepted, including the null terminator; the
+   path parsers in filesys/ copy names into buffers this big */
+#define PATH_MAX_LEN 128
+
+/* Most pages of a user buffer pinned at once by one system call.
+   Larger buffers are moved a piece at a time, so no process can
+   pin enough of the user pool to leave nothing to evict. */
+#define XFER_PAGES 4
 
-#define TO_ARG(ESP, X) (*(int *)(ESP + 4*X))
+/* Number of argument words each system call takes */
+static const uint8_t syscall_argc[] =
+{
+  [SYS_HALT] = 0, [SYS_EXIT] = 1, [SYS_EXEC] = 1, [SYS_WAIT] = 1,
+  [SYS_CREATE] = 2, [SYS_REMOVE] = 1, [SYS_OPEN] = 1, [SYS_FILESIZE] = 1,
+  [SYS_READ] = 3, [SYS_WRITE] = 3, [SYS_SEEK] = 2, [SYS_TELL] = 1,
+  [SYS_CLOSE] = 1, [SYS_MMAP] = 2, [SYS_MUNMAP] = 1, [SYS_CHDIR] = 1,
+  [SYS_MKDIR] = 1, [SYS_READDIR] = 2, [SYS_ISDIR] = 1, [SYS_INUMBER] = 1,
+  [SYS_READV] = 3, [SYS_WRITEV] = 3, [SYS_PREAD] = 4, [SYS_PWRITE] = 4,
+  [SYS_COPY_FILE_RANGE] = 3, [SYS_RING_SETUP] = 1, [SYS_RING_ENTER] = 1,
+  [SYS_AIO_READ] = 4, [SYS_AIO_WRITE] = 4, [SYS_AIO_POLL] = 1,
+  [SYS_AIO_WAIT] = 1, [SYS_PERF_READ] = 3,
+  [SYS_PERF_TRACK] = 0, [SYS_PERF_HIST] = 3, [SYS_TRACE] = 1,
+};
 
 void
 syscall_init (void) 
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+  aio_init ();
 }
 
 void exit (int status)
@@ -63,6 +120,7 @@ void exit (int status)
   strlcpy(thread_full_name, thread_name(), 128);
   char *process_name, *save_prt;
   process_name = strtok_r(thread_full_name, " ", &save_prt);
+  stdout_flush();
   printf("%s: exit(%d)\n", process_name, status);
   thread_current()->userprog_status = status;
   thread_exit();
@@ -75,15 +133,22 @@ syscall_handler (struct intr_frame *f)
   // hex_dump((uint32_t)f->esp, f->esp, (PHYS_BASE - f->esp), 1);
   // intr_dump_frame (f);
   // debug_backtrace();
+  uint64_t start = rdtsc();
   char *esp = f->esp;
-  uint32_t syscall = TO_ARG(esp,0), arg0 = TO_ARG(esp, 1), arg1 = TO_ARG(esp, 2), arg2 = TO_ARG(esp, 3);
-  /* Check memory access */
-  if(esp >= PHYS_BASE - 4)
+  uint32_t syscall, arg[4] = {0, 0, 0, 0};
+  char path[PATH_MAX_LEN];
+  /* Copy in the number and exactly the arguments it takes */
+  if(!copy_from_user(&syscall, esp, sizeof syscall))
   {
     // intr_dump_frame (f);
     exit(-1);
   }
-  int ret_val;
+  if(syscall < sizeof syscall_argc
+     && !copy_from_user(arg, esp + 4, syscall_argc[syscall] * sizeof *arg))
+    exit(-1);
+  uint32_t arg0 = arg[0], arg1 = arg[1], arg2 = arg[2], arg3 = arg[3];
+  int ret_val = -1;
+  perf_syscall(syscall);
   switch (syscall)
   {
       /* code */
@@ -100,13 +165,13 @@ syscall_handler (struct intr_frame *f)
       ret_val = wait(arg0);
       break;
     case SYS_CREATE:                /* Create a file. */
-      ret_val = create(arg0, arg1);
+      ret_val = create(copy_in_path(path, arg0), arg1);
       break;
     case SYS_REMOVE:                 /* Delete a file. */
-      ret_val = remove(arg0);
+      ret_val = remove(copy_in_path(path, arg0));
       break;
     case SYS_OPEN:                   /* Open a file. */
-      ret_val = open(arg0);
+      ret_val = open(copy_in_path(path, arg0));
       break;
     case SYS_FILESIZE:               /* Obtain a file's size. */
       ret_val = filesize(arg0);
@@ -133,10 +198,10 @@ syscall_handler (struct intr_frame *f)
       munmap(arg0);
       break;
     case SYS_CHDIR:                  /* Change curent directory of the process to dir  */
-      ret_val = chdir(arg0);
+      ret_val = chdir(copy_in_path(path, arg0));
       break;
     case SYS_MKDIR:                  /* Make a new directory named dir */ 
-      ret_val = mkdir(arg0);
+      ret_val = mkdir(copy_in_path(path, arg0));
       break;
     case SYS_READDIR:                /* Read an directory entries */
       ret_val = readdir(arg0, arg1);
@@ -147,26 +212,88 @@ syscall_handler (struct intr_frame *f)
     case SYS_INUMBER:
       ret_val = inumber(arg0);       /* Return the inode number of fd */
       break;
+    case SYS_READV:                  /* Read into a scatter list */
+      ret_val = readv(arg0, (const struct iovec *) arg1, arg2);
+      break;
+    case SYS_WRITEV:                 /* Write from a gather list */
+      ret_val = writev(arg0, (const struct iovec *) arg1, arg2);
+      break;
+    case SYS_PREAD:                  /* Read at a given offset */
+      ret_val = pread(arg0, (void *) arg1, arg2, arg3);
+      break;
+    case SYS_PWRITE:                 /* Write at a given offset */
+      ret_val = pwrite(arg0, (const void *) arg1, arg2, arg3);
+      break;
+    case SYS_COPY_FILE_RANGE:        /* Copy between files in the kernel */
+      ret_val = copy_file_range(arg0, arg1, arg2);
+      break;
+    case SYS_RING_SETUP:             /* Register a batched syscall ring */
+      ret_val = ring_setup((struct sys_ring *) arg0);
+      break;
+    case SYS_RING_ENTER:             /* Run requests queued in the ring */
+      ret_val = ring_enter(arg0);
+      break;
+    case SYS_AIO_READ:               /* Start an asynchronous read */
+      ret_val = aio_rw(arg0, (void *) arg1, arg2, arg3, false);
+      break;
+    case SYS_AIO_WRITE:              /* Start an asynchronous write */
+      ret_val = aio_rw(arg0, (void *) arg1, arg2, arg3, true);
+      break;
+    case SYS_AIO_POLL:               /* Check an asynchronous request */
+      ret_val = aio_poll(arg0);
+      break;
+    case SYS_AIO_WAIT:               /* Wait for an asynchronous request */
+      ret_val = aio_wait(arg0);
+      break;
+    case SYS_PERF_READ:              /* Read kernel performance counters */
+      ret_val = perf_read(arg0, arg1, (uint64_t *) arg2);
+      break;
+    case SYS_PERF_TRACK:             /* Keep latency histograms for us */
+      ret_val = perf_lat_track();
+      break;
+    case SYS_PERF_HIST:              /* Read a latency histogram */
+      ret_val = perf_hist(arg0, arg1, (uint32_t *) arg2);
+      break;
+    case SYS_TRACE:                  /* Start or stop event tracing */
+      if(arg0)
+        ret_val = trace_start();
+      else
+      {
+        trace_stop();
+        ret_val = true;
+      }
+      break;
     default:
       break;
   }
   f->eax = ret_val;
+  if(syscall < PERF_SYSCALL_CNT)
+    perf_lat_record(PERF_LAT_SYSCALL_BASE + syscall, start);
 }
 
 static void halt (void)
 {
   DBG_MSG_USERPROG("[%s] calls halt\n", thread_name());
+  stdout_flush();
   shutdown_power_off();
 }
 
 static pid_t exec (const char *file)
 {
-    DBG_MSG_USERPROG("[%s] calls exec %s \n", thread_name(), file);
-    if(file == NULL || !file)
+    /* The command line may be longer than a path */
+    char *cmdline = palloc_get_page(0);
+    if(cmdline == NULL)
+      return PID_ERROR;
+    if(strncpy_from_user(cmdline, file, PGSIZE) < 0)
     {
+      palloc_free_page(cmdline);
       exit(-1);
     }
-    pid_t pid = process_execute(file);
+    DBG_MSG_USERPROG("[%s] calls exec %s \n", thread_name(), cmdline);
+    /* Our output so far goes out before the child's */
+    stdout_flush();
+    pid_t pid = process_execute(cmdline);
+    palloc_free_page(cmdline);
     return pid;
 
 }
@@ -174,19 +301,20 @@ static pid_t exec (const char *file)
 static int wait (pid_t p)
 {
   DBG_MSG_USERPROG("[%s] calls wait to %d\n", thread_name(), p);
+  stdout_flush();
   return process_wait(p);
 }
 
 static bool create (const char *file, unsigned initial_size)
 {
-  DBG_MSG_USERPROG("[%s] calls create %s\n", thread_name(), file);
-  if(file == NULL || !*file)
+  if(file == NULL) /* Too long */
   {
-    exit(-1);
+    return 0;
   }
-  if(strlen(file) > UCHAR_MAX)
+  DBG_MSG_USERPROG("[%s] calls create %s\n", thread_name(), file);
+  if(!*file)
   {
-    return 0;
+    exit(-1);
   }
   /* Create new dir here */
   return filesys_create(file, initial_size);
@@ -194,8 +322,12 @@ static bool create (const char *file, unsigned initial_size)
 
 static bool remove (const char *file)
 {
+  if(file == NULL) /* Too long */
+  {
+    return false;
+  }
   DBG_MSG_USERPROG("[%s] calls remove %s\n", thread_name(), file);
-  if(file == NULL || !*file)
+  if(!*file)
   {
     exit(-1);
   }
@@ -204,7 +336,6 @@ static bool remove (const char *file)
 
 static int open (const char *file)
 {
-  DBG_MSG_USERPROG("[%s] calls open %s\n", thread_name(), file);
   if(file == NULL || !*file)
   {
     return -1;
@@ -223,24 +354,16 @@ static int open (const char *file)
   }
   if(tmp == NULL) return -1;  /* If failed, return -1 */
   DBG_MSG_FS("[%s] filesys_open %s success\n", thread_name(), file);
-  /* If success find the first index that ofile[index] = NULL
-     and return index + 2 */
-  int i = 0;
-  while(i < NOFILE && (thread_current()->ofile[i].file != NULL || thread_current()->ofile[i].dir != NULL))
-  {
-    i++;
-  }
-  if(i == NOFILE) return -1; /* excess number of opened file */
-  if(tmp->inode->data.flags)
-  {
-      thread_current()->ofile[i].dir = tmp;
-  }
-  else
+  /* If success take a free descriptor slot */
+  int fd = fd_alloc(&thread_current()->fdt);
+  if(fd == -1) /* table cannot grow */
   {
-      thread_current()->ofile[i].file = tmp;
+    file_close(tmp);
+    return -1;
   }
-  // printf("[%s] open %s return %d\n", thread_name(), file, i + 2);
-  return i + 2; 
+  fd_install(&thread_current()->fdt, fd, tmp, tmp->inode->data.flags != 0);
+  // printf("[%s] open %s return %d\n", thread_name(), file, fd);
+  return fd; 
 }
 
 static int filesize (int fd)
@@ -257,52 +380,69 @@ static int filesize (int fd)
     case STDOUT_FILENO: /* stdout */
       exit(-1);
     default:
-      return(file_length(thread_current()->ofile[fd - 2].file));
+      return(file_length(fd_entry(fd)->file));
       break;
   }
 }
 
+/* xfer_func for read() from stdin */
+static int stdin_xfer(void *aux UNUSED, void *buf, unsigned size,
+                      unsigned done UNUSED)
+{
+  return strnlen(buf, size);
+}
+
+/* xfer_func for read() from the file AUX */
+static int read_xfer(void *aux, void *buf, unsigned size,
+                     unsigned done UNUSED)
+{
+  return file_read(aux, buf, size);
+}
+
 static int read (int fd, void *buffer, unsigned length)
 {
-  if(buffer == NULL || fd < 0 || buffer >= PHYS_BASE)
+  if(fd < 0 || fd == STDOUT_FILENO)
   {
     exit(-1);
   }
-  switch (fd)
+  if(fd == STDIN_FILENO) /* stdin */
   {
-    case STDIN_FILENO: /* stdin */
-      return strlen(buffer);
-      break;
-    case STDOUT_FILENO: /* stdout */
-      exit(-1);
-    default:
-      DBG_MSG_USERPROG("[%s] calls read %d bytes from %d\n", thread_name(), length, fd);
-      ASSERT(thread_current()->ofile[fd - 2].file != NULL);
-      return file_read(thread_current()->ofile[fd - 2].file, buffer, length);
-      break;
+    stdout_flush(); /* A prompt shows up before we read */
+    return xfer_pinned(buffer, length, true, stdin_xfer, NULL);
   }
+  struct file *file = fd_to_file(fd);
+  DBG_MSG_USERPROG("[%s] calls read %d bytes from %d\n", thread_name(), length, fd);
+  return xfer_pinned(buffer, length, true, read_xfer, file);
+}
+
+/* xfer_func for write() to stdout */
+static int stdout_xfer(void *aux UNUSED, void *buf, unsigned size,
+                       unsigned done UNUSED)
+{
+  stdout_write(buf, size);
+  return size;
+}
+
+/* xfer_func for write() to the file AUX */
+static int write_xfer(void *aux, void *buf, unsigned size,
+                      unsigned done UNUSED)
+{
+  return file_write(aux, buf, size);
 }
 
 static int write (int fd, const void *buffer, unsigned length)
 {
-  if(buffer == NULL || fd < 0 || buffer >= PHYS_BASE)
+  if(fd < 0 || fd == STDIN_FILENO)
   {
     exit(-1);
   }
-  switch (fd)
-  {
-    case STDIN_FILENO: /* stdin */
-      exit(-1);
-      break;
-    case STDOUT_FILENO: /* stdout */
-      putbuf(buffer, length);
-      break;
-    default:
-      DBG_MSG_USERPROG("[%s] calls write %d bytes to %d\n", thread_name(), length, fd);
-      return file_write(thread_current()->ofile[fd - 2].file, buffer, length);
-      break;
-  }
-  return 0;   
+  if(fd == STDOUT_FILENO) /* stdout */
+    return xfer_pinned((void *) buffer, length, false, stdout_xfer, NULL);
+  struct file *file = fd_entry(fd)->file;
+  if(file == NULL) /* Directory */
+    return -1;
+  DBG_MSG_USERPROG("[%s] calls write %d bytes to %d\n", thread_name(), length, fd);
+  return xfer_pinned((void *) buffer, length, false, write_xfer, file);
 }
 
 static void seek (int fd, unsigned position)
@@ -319,7 +459,7 @@ static void seek (int fd, unsigned position)
     case STDOUT_FILENO: /* stdout */
       exit(-1);
     default:
-      file_seek(thread_current()->ofile[fd - 2].file, position);
+      file_seek(fd_entry(fd)->file, position);
       break;
   }
 }
@@ -338,7 +478,7 @@ static unsigned tell (int fd)
     case STDOUT_FILENO: /* stdout */
       exit(-1);
     default:
-      return file_tell(thread_current()->ofile[fd - 2].file);
+      return file_tell(fd_entry(fd)->file);
       break;
   }
 }
@@ -357,19 +497,419 @@ static void close (int fd)
       exit(-1);
     default:
       DBG_MSG_USERPROG("[%s] calls close to %d\n", thread_name(), fd);
-      if(thread_current()->ofile[fd - 2].file != NULL) /* Didn't open */
       {
-        file_close(thread_current()->ofile[fd - 2].file);
-        thread_current()->ofile[fd - 2].file = NULL;
+        struct openning_file *f = fd_lookup(&thread_current()->fdt, fd);
+        if(f == NULL) /* Didn't open */
+          break;
+        if(f->file != NULL)
+        {
+          file_close(f->file);
+          f->file = NULL;
+        }
+        if(f->dir != NULL)
+        {
+          dir_close(f->dir);
+          f->dir = NULL;
+        }
+        fd_release(&thread_current()->fdt, fd);
       }
-      if(thread_current()->ofile[fd - 2].dir != NULL) /* Didn't open */
+      break;
+  }
+}
+/* Returns the regular file open as FD, killing the process if FD
+   is not one. */
+static struct file *fd_to_file(int fd)
+{
+  struct file *file = fd_entry(fd)->file;
+  if(file == NULL)
+    exit(-1);
+  return file;
+}
+
+/* Returns the descriptor slot of FD, killing the process if FD
+   is not open. */
+static struct openning_file *fd_entry(int fd)
+{
+  struct openning_file *f = fd_lookup(&thread_current()->fdt, fd);
+  if(f == NULL)
+    exit(-1);
+  return f;
+}
+
+/* Copies the IOVCNT entries of user array IOV into KIOV, which
+   has room for IOV_MAX.  Returns IOVCNT, or -1 if it is out of
+   range.  Kills the process if IOV is bad. */
+static int copy_in_iovec(struct iovec *kiov, const struct iovec *iov,
+                         int iovcnt)
+{
+  if(iovcnt < 0 || iovcnt > IOV_MAX)
+    return -1;
+  if(!copy_from_user(kiov, iov, iovcnt * sizeof *kiov))
+    exit(-1);
+  return iovcnt;
+}
+
+/* Returns the number of pages that SIZE bytes at BUF touch */
+static unsigned pages_spanned(const uint8_t *buf, unsigned size)
+{
+  return size == 0 ? 0 : pg_no(buf + size - 1) - pg_no(buf) + 1;
+}
+
+/* Moves LENGTH bytes between user BUFFER and a file or the
+   console by calling XFER on one piece of BUFFER at a time, each
+   touching at most XFER_PAGES pages and pinned while XFER runs,
+   writable ones if WRITE.  XFER gets AUX, the piece, its size and
+   how many bytes came before it, and returns how many bytes it
+   moved.  Stops after a short piece.  Returns the total moved.
+   Kills the process if the memory is bad. */
+static int xfer_pinned(void *buffer, unsigned length, bool write,
+                       xfer_func *xfer, void *aux)
+{
+  uint8_t *buf = buffer;
+  unsigned done = 0;
+  while(done < length)
+  {
+    unsigned size = XFER_PAGES * PGSIZE - pg_ofs(buf + done);
+    if(size > length - done)
+      size = length - done;
+    if(!uaccess_pin(buf + done, size, write))
+      exit(-1);
+    int n = xfer(aux, buf + done, size, done);
+    uaccess_unpin(buf + done, size);
+    if(n > 0)
+      done += n;
+    if(n < (int) size)
+      break;
+  }
+  return done;
+}
+
+/* Reads into, if READ, or writes from the IOVCNT buffers of KIOV
+   with FILE, or the console if FILE is null.  Consecutive
+   buffers are grouped into batches touching at most XFER_PAGES
+   pages, which are pinned and passed to the file system together
+   so each batch takes the inode's lock once.  Stops after a short
+   batch.  Returns the total moved.  Kills the process if the
+   memory is bad. */
+static int xferv_pinned(struct file *file, const struct iovec *kiov,
+                        int iovcnt, bool read)
+{
+  struct iovec batch[IOV_MAX];
+  int i = 0, total = 0;
+  size_t ofs = 0;             /* Bytes of kiov[i] already done */
+  while(i < iovcnt)
+  {
+    unsigned pages = 0, wanted = 0;
+    int n = 0, j, ret = 0;
+
+    /* Gather a batch, splitting a buffer if it does not fit */
+    while(i < iovcnt && pages < XFER_PAGES)
+    {
+      uint8_t *base = (uint8_t *) kiov[i].iov_base + ofs;
+      size_t size = kiov[i].iov_len - ofs;
+      size_t room = (XFER_PAGES - pages) * PGSIZE - pg_ofs(base);
+      if(size > room)
+        size = room;
+      if(size > 0)
+      {
+        if(!uaccess_pin(base, size, read))
+        {
+          for(j = 0; j < n; j++)
+            uaccess_unpin(batch[j].iov_base, batch[j].iov_len);
+          exit(-1);
+        }
+        batch[n].iov_base = base;
+        batch[n].iov_len = size;
+        n++;
+        pages += pages_spanned(base, size);
+        wanted += size;
+        ofs += size;
+      }
+      if(ofs == kiov[i].iov_len)
       {
-        dir_close(thread_current()->ofile[fd - 2].dir);
-        thread_current()->ofile[fd - 2].dir = NULL;
+        i++;
+        ofs = 0;
       }
+    }
+
+    if(file == NULL)
+    {
+      for(j = 0; j < n; j++)
+        stdout_write(batch[j].iov_base, batch[j].iov_len);
+      ret = wanted;
+    }
+    else if(read)
+      ret = file_readv(file, batch, n);
+    else
+      ret = file_writev(file, batch, n);
+    for(j = 0; j < n; j++)
+      uaccess_unpin(batch[j].iov_base, batch[j].iov_len);
+    if(ret > 0)
+      total += ret;
+    if(ret < (int) wanted)
       break;
   }
+  return total;
+}
+
+/* Copies user path UPATH into PATH, which holds PATH_MAX_LEN
+   bytes.  Returns PATH, or a null pointer if the path is too
+   long.  Kills the process if UPATH is not a valid string. */
+static const char *copy_in_path(char *path, const char *upath)
+{
+  int len = strncpy_from_user(path, upath, PATH_MAX_LEN);
+  if(len < 0)
+    exit(-1);
+  return len < PATH_MAX_LEN ? path : NULL;
+}
+
+/* Reads into the IOVCNT buffers of IOV from FD, taking the
+   inode's lock once for each batch of buffers.  Returns the
+   number of bytes read, or -1 if IOVCNT is out of range. */
+static int readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  struct iovec kiov[IOV_MAX];
+  if(fd == STDIN_FILENO || fd == STDOUT_FILENO)
+    exit(-1);
+  struct file *file = fd_to_file(fd);
+  if(copy_in_iovec(kiov, iov, iovcnt) < 0)
+    return -1;
+  DBG_MSG_USERPROG("[%s] calls readv %d buffers from %d\n", thread_name(), iovcnt, fd);
+  return xferv_pinned(file, kiov, iovcnt, true);
+}
+
+/* Writes the IOVCNT buffers of IOV to FD, taking the inode's
+   lock once for each batch of buffers.  Returns the number of
+   bytes written, or -1 if IOVCNT is out of range. */
+static int writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  struct iovec kiov[IOV_MAX];
+  if(fd == STDIN_FILENO)
+    exit(-1);
+  struct file *file = fd == STDOUT_FILENO ? NULL : fd_to_file(fd);
+  if(copy_in_iovec(kiov, iov, iovcnt) < 0)
+    return -1;
+  DBG_MSG_USERPROG("[%s] calls writev %d buffers to %d\n", thread_name(), iovcnt, fd);
+  return xferv_pinned(file, kiov, iovcnt, false);
+}
+
+/* File and starting offset of a pread() or pwrite() */
+struct xfer_at
+{
+  struct file *file;
+  unsigned offset;
+};
+
+/* xfer_func for pread() */
+static int pread_xfer(void *aux, void *buf, unsigned size, unsigned done)
+{
+  struct xfer_at *x = aux;
+  if(x->offset + done >= (unsigned) file_length(x->file))
+    return 0;
+  return file_read_at(x->file, buf, size, x->offset + done);
+}
+
+/* xfer_func for pwrite() */
+static int pwrite_xfer(void *aux, void *buf, unsigned size, unsigned done)
+{
+  struct xfer_at *x = aux;
+  return file_write_at(x->file, buf, size, x->offset + done);
+}
+
+/* Reads LENGTH bytes at OFFSET of FD into BUFFER without moving
+   the file position. */
+static int pread (int fd, void *buffer, unsigned length, unsigned offset)
+{
+  struct xfer_at x = { fd_to_file(fd), offset };
+  return xfer_pinned(buffer, length, true, pread_xfer, &x);
+}
+
+/* Writes LENGTH bytes from BUFFER at OFFSET of FD without moving
+   the file position. */
+static int pwrite (int fd, const void *buffer, unsigned length,
+                   unsigned offset)
+{
+  struct xfer_at x = { fd_to_file(fd), offset };
+  return xfer_pinned((void *) buffer, length, false, pwrite_xfer, &x);
+}
+
+/* Copies up to LENGTH bytes from FD_IN's position to FD_OUT's
+   position inside the kernel, buffer cache to buffer cache, and
+   advances both.  Returns the number of bytes copied, 0 at end
+   of FD_IN, or -1 if FD_OUT cannot be written. */
+static int copy_file_range (int fd_in, int fd_out, unsigned length)
+{
+  struct file *in = fd_to_file(fd_in);
+  struct file *out = fd_to_file(fd_out);
+  DBG_MSG_USERPROG("[%s] calls copy_file_range %d bytes from %d to %d\n", thread_name(), length, fd_in, fd_out);
+  return file_copy(out, in, length);
+}
+
+/* Registers the page at RING as the process's syscall ring and
+   pins it, so ring_enter() can read and write it directly.  Only
+   one ring may be registered. */
+static bool ring_setup (struct sys_ring *ring)
+{
+  struct thread *cur = thread_current();
+  if(cur->ring != NULL || pg_ofs(ring) != 0)
+    return false;
+  if(!uaccess_pin(ring, PGSIZE, true))
+    return false;
+  cur->ring = ring;
+  return true;
 }
+
+/* Runs one ring request and returns its result. */
+static int ring_dispatch (const struct ring_sqe *sqe)
+{
+  char path[PATH_MAX_LEN];
+  switch (sqe->op)
+  {
+    case RING_OP_NOP:
+      return 0;
+    case RING_OP_READ:
+      return read(sqe->fd, sqe->buf, sqe->len);
+    case RING_OP_WRITE:
+      return write(sqe->fd, sqe->buf, sqe->len);
+    case RING_OP_PREAD:
+      return pread(sqe->fd, sqe->buf, sqe->len, sqe->off);
+    case RING_OP_PWRITE:
+      return pwrite(sqe->fd, sqe->buf, sqe->len, sqe->off);
+    case RING_OP_SEEK:
+      seek(sqe->fd, sqe->off);
+      return 0;
+    case RING_OP_TELL:
+      return tell(sqe->fd);
+    case RING_OP_FILESIZE:
+      return filesize(sqe->fd);
+    case RING_OP_OPEN:
+      return open(copy_in_path(path, sqe->buf));
+    case RING_OP_CLOSE:
+      close(sqe->fd);
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+/* Runs up to TO_SUBMIT requests queued in the process's ring, in
+   order, posting a completion for each, all within this one
+   kernel entry.  Stops early when the submission queue is empty
+   or the completion queue is full.  Returns the number of
+   requests run, or -1 if no ring is registered.  A request with
+   bad arguments kills the process, as the system call would. */
+static int ring_enter (unsigned to_submit)
+{
+  struct sys_ring *r = thread_current()->ring;
+  unsigned done = 0;
+  if(r == NULL)
+    return -1;
+  DBG_MSG_USERPROG("[%s] calls ring_enter %d\n", thread_name(), to_submit);
+  while(done < to_submit && r->sq_head != r->sq_tail
+        && r->cq_tail - r->cq_head < RING_CQ_ENTRIES)
+  {
+    /* Take a private copy, the process owns the slot again as
+       soon as sq_head moves past it. */
+    struct ring_sqe sqe = r->sq[r->sq_head % RING_SQ_ENTRIES];
+    r->sq_head++;
+    int res = ring_dispatch(&sqe);
+    struct ring_cqe *cqe = &r->cq[r->cq_tail % RING_CQ_ENTRIES];
+    cqe->user_data = sqe.user_data;
+    cqe->res = res;
+    r->cq_tail++;
+    done++;
+  }
+  return done;
+}
+
+/* Starts an asynchronous transfer of LENGTH bytes between BUFFER
+   and FD at OFFSET, a write to the file if WRITE.  The buffer
+   stays pinned until aio_wait() reaps the request.  Returns the
+   request id, or -1 if it cannot be queued. */
+static int aio_rw (int fd, void *buffer, unsigned length, unsigned offset,
+                   bool write)
+{
+  struct file *file = fd_to_file(fd);
+  if(length > AIO_MAX_LEN)
+    return -1;
+  /* A read from the file writes into the buffer */
+  if(!uaccess_pin(buffer, length, !write))
+    exit(-1);
+  int id = aio_submit(file_get_inode(file), buffer, length, offset, write);
+  if(id < 0)
+    uaccess_unpin(buffer, length);
+  return id;
+}
+
+/* 
+  Write to the console through the process's line buffer, so a
+  chatty process takes the console lock once per line instead of
+  once per write(). Like stdio's line buffering, the buffer is
+  flushed when a newline goes in or it fills up. Writes of a whole
+  buffer or more skip it.
+*/
+static void stdout_write(const char *buffer, size_t length)
+{
+  struct thread *cur = thread_current();
+  if(cur->out_buf == NULL && length < OUT_BUF_SIZE)
+    cur->out_buf = malloc(OUT_BUF_SIZE);
+  if(cur->out_buf == NULL || (cur->out_len == 0 && length >= OUT_BUF_SIZE))
+  {
+    putbuf(buffer, length);
+    return;
+  }
+  while(length > 0)
+  {
+    size_t chunk = OUT_BUF_SIZE - cur->out_len;
+    if(chunk > length)
+      chunk = length;
+    memcpy(cur->out_buf + cur->out_len, buffer, chunk);
+    cur->out_len += chunk;
+    if(cur->out_len == OUT_BUF_SIZE || memchr(buffer, '\n', chunk) != NULL)
+      stdout_flush();
+    buffer += chunk;
+    length -= chunk;
+  }
+}
+
+/* Write out whatever the current process has buffered for stdout */
+void stdout_flush(void)
+{
+  struct thread *cur = thread_current();
+  if(cur->out_len > 0)
+  {
+    putbuf(cur->out_buf, cur->out_len);
+    cur->out_len = 0;
+  }
+}
+
+/* Copy counters FIRST up to FIRST + CNT (see lib/perfctr.h) out to
+   VALUES, stopping at the last counter. Returns how many were
+   copied */
+static int perf_read (unsigned first, unsigned cnt, uint64_t *values)
+{
+  unsigned i;
+  for(i = 0; first < PERF_TOTAL && i < cnt && i < PERF_TOTAL - first; i++)
+  {
+    uint64_t v = perf_get(first + i);
+    if(!copy_to_user(values + i, &v, sizeof v))
+      exit(-1);
+  }
+  return i;
+}
+
+/* Copy latency histogram ID, the process's own if SELF, out to
+   the PERF_LAT_BUCKETS elements of BUCKETS */
+static bool perf_hist (unsigned id, bool self, uint32_t *buckets)
+{
+  uint32_t kbuckets[PERF_LAT_BUCKETS];
+  if(!perf_lat_read(id, self, kbuckets))
+    return false;
+  if(!copy_to_user(buckets, kbuckets, sizeof kbuckets))
+    exit(-1);
+  return true;
+}
+
 static bool is_valid_mmap_vaddr(void *vaddr);
 /*
 map an opened file fd to the address vaddr
@@ -381,12 +921,11 @@ static mmapid_t mmap(int fd, uint8_t *vaddr)
   if(!is_valid_mmap_vaddr(vaddr))
     return -1;
   /* Valid file */
-  if(fd <= STDOUT_FILENO || fd >= NOFILE || filesize(fd) == 0)
+  struct openning_file *f = fd_lookup(&thread_current()->fdt, fd);
+  if(f == NULL || f->file == NULL) return -1; /* No file */
+  if(filesize(fd) == 0)
     return -1;
-  /* Goto the file array */
   DBG_MSG_FS("[VM: %s] mapping file..\n", thread_name());
-  struct openning_file *f = &thread_current()->ofile[fd - 2];
-  if(f->file == NULL) return -1; /* No file */
   if(f->mmap_start != NULL) return -1; /* no remap now */
   f->mfile = file_reopen(f->file);
   f->mmap_start = vaddr;
@@ -415,8 +954,8 @@ static mmapid_t mmap(int fd, uint8_t *vaddr)
 
 void munmap(mmapid_t mapping)
 {
-  struct openning_file *f = &thread_current()->ofile[mapping - 2];
-  ASSERT(f->mfile != NULL && f->mmap_start != NULL && f->mmap_end != NULL); // valid mmap
+  struct openning_file *f = fd_lookup(&thread_current()->fdt, mapping);
+  ASSERT(f != NULL && f->mfile != NULL && f->mmap_start != NULL && f->mmap_end != NULL); // valid mmap
   uint8_t *a, *k;
   off_t file_offset = 0;
   for(a = f->mmap_start; a < f->mmap_end ; a += PGSIZE)
@@ -446,6 +985,7 @@ void munmap(mmapid_t mapping)
   f->mfile = NULL;
   f->mmap_start = NULL;
   f->mmap_end = NULL;
+  fd_release(&thread_current()->fdt, mapping);
 }
 
 static bool is_valid_mmap_vaddr(void *vaddr)
@@ -471,6 +1011,8 @@ static bool is_valid_mmap_vaddr(void *vaddr)
 
 static bool chdir(const char *dir)
 {
+  if(dir == NULL) /* Too long */
+    return false;
    /*
   Implementation:
   If the string start with / --> absolute path --> chdir to root
@@ -503,18 +1045,26 @@ static bool mkdir(const char *dir)
 
 static bool readdir(int fd, char *name)
 {
-  return dir_readdir(thread_current()->ofile[fd - 2].dir, name);
+  char kname[NAME_MAX + 1];
+  struct dir *dir = fd_entry(fd)->dir;
+  if(dir == NULL)
+    return false;
+  if(!dir_readdir(dir, kname))
+    return false;
+  if(!copy_to_user(name, kname, strlen(kname) + 1))
+    exit(-1);
+  return true;
 }
 
 static bool isdir(int fd)
 {
-  return (thread_current()->ofile[fd - 2].dir != NULL);
+  return (fd_entry(fd)->dir != NULL);
 }
 
 static int inumber(int fd)
 {
-  if(thread_current()->ofile[fd - 2].dir != NULL)
-    return thread_current()->ofile[fd - 2].dir->inode->sector;
-  if(thread_current()->ofile[fd - 2].file != NULL)
-    return thread_current()->ofile[fd - 2].file->inode->sector;
+  if(fd_entry(fd)->dir != NULL)
+    return fd_entry(fd)->dir->inode->sector;
+  if(fd_entry(fd)->file != NULL)
+    return fd_entry(fd)->file->inode->sector;
 }
\ No newline at end of file
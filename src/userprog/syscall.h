@@ -14,5 +14,6 @@ typedef int mmapid_t;
 
 void exit (int status);
 void munmap(mmapid_t mapping);
+void stdout_flush(void);
 
 #endif /* userprog/syscall.h */
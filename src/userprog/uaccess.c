@@ -0,0 +1,139 @@
+#include "userprog/uaccess.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+
+/* Returns true if [UADDR, UADDR + SIZE) lies entirely in user
+   space, below PHYS_BASE, and does not start at page 0. */
+static bool
+is_user_range (const void *uaddr, size_t size) 
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start >= PGSIZE
+         && size <= (uintptr_t) PHYS_BASE
+         && start <= (uintptr_t) PHYS_BASE - size;
+}
+
+/* Copies SIZE bytes from SRC to DST with `rep movsb', with the
+   current thread's fault fixup pointing just past it.  If either
+   side faults and the page fault handler cannot bring the page
+   in, it resumes at the fixup with ECX still holding the count
+   that was not copied.  Returns that count, 0 on success. */
+static size_t
+copy_bytes (void *dst, const void *src, size_t size) 
+{
+  struct thread *t = thread_current ();
+
+  asm volatile ("movl $1f, %[fixup]\n\t"
+                "rep movsb\n"
+                "1:\n\t"
+                "movl $0, %[fixup]"
+                : "+D" (dst), "+S" (src), "+c" (size),
+                  [fixup] "=m" (t->fault_fixup)
+                :
+                : "memory");
+  return size;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel buffer DST.
+   Returns false if any part of USRC is not readable user
+   memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size) 
+{
+  if (!is_user_range (usrc, size))
+    return false;
+  return copy_bytes (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel buffer SRC to user address UDST.
+   Returns false if any part of UDST is not writable user
+   memory; a prefix may have been written. */
+bool
+copy_to_user (void *udst, const void *src, size_t size) 
+{
+  if (!is_user_range (udst, size))
+    return false;
+  return copy_bytes (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated user string USRC into DST, which
+   has room for SIZE bytes.  Returns the length of the string, or
+   -1 if USRC runs into memory that is not readable user memory.
+   If the string does not fit, DST is truncated to SIZE - 1
+   characters and SIZE is returned. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size) 
+{
+  size_t i;
+
+  ASSERT (size > 0);
+  for (i = 0; i < size; i++)
+    {
+      if (!is_user_range (usrc + i, 1) || copy_bytes (dst + i, usrc + i, 1))
+        return -1;
+      if (dst[i] == '\0')
+        return i;
+    }
+  dst[size - 1] = '\0';
+  return size;
+}
+
+/* Makes every page of [UADDR, UADDR + SIZE) resident and pins its
+   frame, so the file system can read or write the range directly
+   without taking page faults or losing a page to eviction while
+   it holds its locks.  With WRITE, the pages must also be
+   writable.  Returns false, with nothing left pinned, if the
+   range is not valid user memory. */
+bool
+uaccess_pin (const void *uaddr, size_t size, bool write) 
+{
+  uint32_t *pd = thread_current ()->pagedir;
+  const uint8_t *first, *page;
+
+  if (size == 0)
+    return true;
+  if (!is_user_range (uaddr, size))
+    return false;
+
+  first = pg_round_down (uaddr);
+  for (page = first; page < (const uint8_t *) uaddr + size; page += PGSIZE)
+    while (!frame_pin (page))
+      {
+        /* Not resident: fault it in through the fixup, then try
+           again, since it may be evicted before it is pinned. */
+        uint8_t byte;
+        if (copy_bytes (&byte, page, 1) != 0)
+          {
+            uaccess_unpin (first, page - first);
+            return false;
+          }
+      }
+
+  if (write)
+    for (page = first; page < (const uint8_t *) uaddr + size; page += PGSIZE)
+      if (!pagedir_is_writable (pd, page))
+        {
+          uaccess_unpin (uaddr, size);
+          return false;
+        }
+  return true;
+}
+
+/* Unpins the pages of [UADDR, UADDR + SIZE) pinned by
+   uaccess_pin(). */
+void
+uaccess_unpin (const void *uaddr, size_t size) 
+{
+  const uint8_t *page;
+
+  if (size == 0)
+    return;
+  for (page = pg_round_down (uaddr); page < (const uint8_t *) uaddr + size;
+       page += PGSIZE)
+    frame_unpin (page);
+}
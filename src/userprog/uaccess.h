@@ -0,0 +1,21 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Checked access to user memory from system calls.
+
+   Every copy runs with a fault fixup armed, so a bad user
+   address makes the copy fail instead of killing the kernel
+   thread from inside the page fault handler.  Ranges that a
+   call hands to the file system directly are pinned first. */
+
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int strncpy_from_user (char *dst, const char *usrc, size_t size);
+
+bool uaccess_pin (const void *uaddr, size_t size, bool write);
+void uaccess_unpin (const void *uaddr, size_t size);
+
+#endif /* userprog/uaccess.h */
@@ -19,16 +19,18 @@
 #include "swap.h"
 #include "page.h"
 #include "threads/interrupt.h"
+#include "threads/trace.h"
 struct _frame frame;
 extern struct _swap swap;
-static uint8_t *frame_to_be_evicted();
+static uint8_t *frame_to_be_evicted(void);
 static bool frame_table_is_restricted(uint8_t *pframe);
+static uint32_t frame_index(const uint8_t *pframe);
 
 /*
     Init the frame table
 */
 
-void frame_init()
+void frame_init(void)
 {
     lock_init(&frame.lock);
     uint32_t npage = ROUND_UP(init_ram_pages, PGSIZE/sizeof(uint32_t));
@@ -45,7 +47,7 @@ void frame_init()
 /* Frame table manipulation*/
 void frame_table_get(uint8_t *pframe, struct thread **t, uint8_t **upage, bool lock)
 {
-    uint32_t index =  (uint32_t) pframe / PGSIZE - (1024*1024)/PGSIZE - frame.total_frames/2 - 1;
+    uint32_t index = frame_index(pframe);
     if(lock) lock_acquire(&frame.lock);
     *t = frame.frame_table[index].thread;
     *upage = frame.frame_table[index].page;
@@ -54,7 +56,7 @@ void frame_table_get(uint8_t *pframe, struct thread **t, uint8_t **upage, bool l
 
 void frame_table_set(uint8_t *pframe, struct thread *t, uint8_t *page, bool lock)
 {
-    uint32_t index =  (uint32_t) pframe / PGSIZE - (1024*1024)/PGSIZE - frame.total_frames/2 - 1;
+    uint32_t index = frame_index(pframe);
     // DBG_MSG_VM("[VM: %s] adding new pages to frame table at %d value 0x%x\n", thread_name(), index, page);
     if(lock) lock_acquire(&frame.lock);
     frame.frame_table[index].thread = t;
@@ -62,6 +64,12 @@ void frame_table_set(uint8_t *pframe, struct thread *t, uint8_t *page, bool lock
     if(lock) lock_release(&frame.lock);
 }
 
+/* Index in the frame table of physical frame PFRAME */
+static uint32_t frame_index(const uint8_t *pframe)
+{
+    return (uint32_t) pframe / PGSIZE - (1024*1024)/PGSIZE - frame.total_frames/2 - 1;
+}
+
 uint8_t *frame_table_get_pframe(uint32_t index)
 {
     return (uint8_t *) ((index + (1024*1024)/PGSIZE + frame.total_frames/2 + 1)*PGSIZE);
@@ -80,6 +88,7 @@ void *frame_alloc(void * vpage)
     /* Update the frame table entry at pframe */
         frame_table_set(vtop(kpage), thread_current(), vpage, false);
         lock_release(&frame.lock);
+        trace(TRACE_FRAME_ALLOC, (uint32_t) vpage, (uint32_t) kpage);
         // DBG_MSG_VM("[VM: %s] new page allocated for 0x%x \n", thread_name(), vpage);
         return kpage;
     }
@@ -105,6 +114,7 @@ void *frame_alloc(void * vpage)
         } while (frame_table_is_restricted(pframe));
         frame_table_get(pframe, &t, &upage, false);
         ASSERT(upage != NULL && t != NULL);
+        trace(TRACE_FRAME_EVICT, (uint32_t) upage, t->tid);
         DBG_MSG_VM("[VM: %s] swap page 0x%x to swap slot %d entries %s\n", thread_name(), upage, swap_page, t->name);
         /* TODO: Update supp table */
         while(page_table_insert(t, upage, swap_page << PGBITS) != NULL) 
@@ -128,26 +138,33 @@ void *frame_alloc(void * vpage)
         lock_release(&swap.lock);
         lock_release(&frame.lock);
         memset(ptov(pframe), 0, PGSIZE);
+        trace(TRACE_FRAME_ALLOC, (uint32_t) vpage, (uint32_t) ptov(pframe));
         // DBG_MSG_VM("[VM: %s] swap page 0x%x to swap slot %d entries %s\n", thread_name(), upage, swap_page, t->name);
         return ptov(pframe);
     }
 }
 
+/* Clear the frame table entry of KPAGE, mapped by process T */
+static void frame_table_clear(void *upage UNUSED, void *kpage, void *t)
+{
+    uint32_t index = frame_index((uint8_t *) vtop(kpage));
+    ASSERT(frame.frame_table[index].thread == t);
+    frame.frame_table[index].thread = NULL;
+    frame.frame_table[index].page = NULL;
+    frame.frame_table[index].aux = NULL;
+    frame.frame_table[index].pin_cnt = 0;
+}
+
+/*
+    Drop the frame table entries of process t. Every frame t owns
+    is mapped in its page directory (eviction unmaps a frame before
+    giving it away), so walk that instead of the whole frame table.
+    Caller holds frame.lock
+*/
 void frame_table_free(struct thread *t)
 {
-    int i;
-    // lock_acquire(&frame.lock);
-    for(i = 0; i < frame.user_frames; i++)
-    {
-        if(frame.frame_table[i].thread == t)
-        {
-            // DBG_MSG_VM("[VM: %s] free frame entry 0x%x\n", thread_name(), frame_table_get_pframe(i));
-            frame.frame_table[i].thread = NULL;
-            frame.frame_table[i].page = NULL;
-            frame.frame_table[i].aux = NULL;
-        }
-    }
-    // lock_release(&frame.lock);
+    if(t->pagedir != NULL)
+        pagedir_for_each(t->pagedir, frame_table_clear, t);
 }
 
 void frame_free(void *kpage)
@@ -160,7 +177,7 @@ void frame_free(void *kpage)
     lock_release(&frame.lock);
 }
 
-void frame_destroy()
+void frame_destroy(void)
 {
     int npage = ROUND_UP(init_ram_pages, PGSIZE/sizeof(uint32_t));
     // frame_table_dump();
@@ -169,26 +186,53 @@ void frame_destroy()
 
 void frame_table_set_restricted(uint8_t *pframe, void *access)
 {
-    uint32_t index =  (uint32_t) pframe / PGSIZE - (1024*1024)/PGSIZE - frame.total_frames/2 - 1;
+    uint32_t index = frame_index(pframe);
     lock_acquire(&frame.lock);
     frame.frame_table[index].aux = access;
     lock_release(&frame.lock);
 }
-static bool frame_table_is_restricted(uint8_t *pframe)
+/*
+    Pin the frame holding user page UPAGE of the current thread so
+    it is not chosen for eviction. Checked under the frame lock, so
+    the page cannot be evicted between the lookup and the pin.
+    Pins are counted: the frame stays pinned until every
+    frame_pin() of it has been undone by a frame_unpin().
+    Return false if UPAGE is not resident.
+*/
+bool frame_pin(const void *upage)
+{
+    lock_acquire(&frame.lock);
+    uint8_t *kpage = pagedir_get_page(thread_current()->pagedir, upage);
+    if(kpage != NULL)
+        frame.frame_table[frame_index((uint8_t *) vtop(kpage))].pin_cnt++;
+    lock_release(&frame.lock);
+    return kpage != NULL;
+}
+
+/* Undo frame_pin() */
+void frame_unpin(const void *upage)
 {
-    void *access;
-    uint32_t index =  (uint32_t) pframe / PGSIZE - (1024*1024)/PGSIZE - frame.total_frames/2 - 1;
-    // lock_acquire(&frame.lock);
-    access = frame.frame_table[index].aux;
-    // lock_release(&frame.lock);
-    if(access == -1) 
+    lock_acquire(&frame.lock);
+    uint8_t *kpage = pagedir_get_page(thread_current()->pagedir, upage);
+    if(kpage != NULL)
     {
-        return true;
+        uint32_t index = frame_index((uint8_t *) vtop(kpage));
+        ASSERT(frame.frame_table[index].pin_cnt > 0);
+        frame.frame_table[index].pin_cnt--;
     }
-    else return false;
+    lock_release(&frame.lock);
+}
+
+/* A frame may not be evicted while it is being loaded, while it
+   holds a page the kernel faulted in, or while it is pinned */
+static bool frame_table_is_restricted(uint8_t *pframe)
+{
+    uint32_t index = frame_index(pframe);
+    return frame.frame_table[index].aux == (void *) -1
+           || frame.frame_table[index].pin_cnt > 0;
 }
 
-static uint8_t *frame_to_be_evicted()
+static uint8_t *frame_to_be_evicted(void)
 {
     static uint32_t i = 0;
     uint32_t f;
@@ -203,7 +247,7 @@ static uint8_t *frame_to_be_evicted()
     return frame_table_get_pframe(f);
 }
 
-void frame_table_dump()
+void frame_table_dump(void)
 {
     int i;
     for(i = 0 ; i < frame.user_frames; ++i)
@@ -13,6 +13,7 @@ struct _frame_table
     struct thread *thread;
     uint8_t *page;
     void *aux;
+    uint32_t pin_cnt; /* Number of frame_pin() calls not yet undone */
 };
 
 struct _frame
@@ -44,16 +45,18 @@ Only the supp table is local (thread scope)
    A PDE or PTE that is initialized to 0 will be interpreted as
    "not present", which is just fine. */
 
-void frame_init();
+void frame_init(void);
 void *frame_alloc(void *);
 void frame_free(void *);
 void frame_table_get(uint8_t *pframe, struct thread **t, uint8_t **page, bool lock);
 void frame_table_set(uint8_t *pframe, struct thread *t, uint8_t *page, bool lock);
 void frame_table_set_restricted(uint8_t *pframe, void *access);
+bool frame_pin(const void *upage);
+void frame_unpin(const void *upage);
 void frame_table_free(struct thread *t);
 uint8_t *frame_table_get_pframe(uint32_t index);
-void frame_destroy();
-void frame_table_dump();
+void frame_destroy(void);
+void frame_table_dump(void);
 
 
 
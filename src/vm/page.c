@@ -12,6 +12,9 @@ static unsigned page_hash (const struct hash_elem *p_, void *aux UNUSED);
 static bool page_less (const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED);
 static void page_destructor(struct hash_elem *e, void *aux UNUSED);
 
+/* Object cache for supplemental page table entries */
+static struct obj_cache *page_cache;
+
 static unsigned page_hash (const struct hash_elem *p_, void *aux UNUSED) 
 {
     const struct page *p = hash_entry (p_, struct page, hash_elem);
@@ -29,7 +32,13 @@ static bool page_less (const struct hash_elem *a_, const struct hash_elem *b_,
 static void page_destructor(struct hash_elem *e, void *aux UNUSED)
 {
     struct page *p = hash_entry(e, struct page, hash_elem);
-    free(p);
+    obj_cache_free(page_cache, p);
+}
+
+void page_init(void)
+{
+    page_cache = obj_cache_create("page", sizeof(struct page));
+    ASSERT(page_cache != NULL);
 }
 
 void page_table_init(struct thread *t)
@@ -43,21 +52,21 @@ void page_table_init(struct thread *t)
 
 struct page* page_table_insert(struct thread *t, const uint8_t *address, uint8_t * aux)
 {
-    struct page *p = malloc(sizeof(struct page));
+    struct page *p = obj_cache_alloc(page_cache);
     p->vaddr = address;
     p->aux = aux;
     // DBG_MSG_VM("[VM: %s] Insert 0x%x and 0x%x to spt\n", thread_name(), p->vaddr, p->aux);
     lock_acquire(&t->page_mgm->lock);
     struct hash_elem *e = hash_insert(t->page_mgm->page_table, &p->hash_elem);
     lock_release(&t->page_mgm->lock);
-    if(e != NULL) free(p);
+    if(e != NULL) obj_cache_free(page_cache, p);
     return e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
 }
 
 void page_table_remove(struct thread *t, struct page *p)
 {
     ASSERT(hash_delete(t->page_mgm->page_table, &p->hash_elem) == p);
-    free(p);
+    obj_cache_free(page_cache, p);
 }
 
 struct page *page_table_lookup(struct thread *t, const uint8_t *address)
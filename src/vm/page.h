@@ -16,6 +16,7 @@ struct page
     uint8_t *aux; /* Aux data, depend on segment of vaddr */
 };
 
+void page_init(void);
 void page_table_init(struct thread *t);
 struct page *page_table_insert(struct thread *t, const uint8_t *address, uint8_t *aux);
 void page_table_remove(struct thread *t, struct page *p);
@@ -10,7 +10,10 @@
 #include "stdio.h"
 #include "round.h"
 #include "frame.h"
+#include "page.h"
 #include "threads/thread.h"
+#include "threads/perf.h"
+#include "threads/trace.h"
 #include "threads/pte.h"
 #include "debug.h"
 struct _swap swap;
@@ -40,6 +43,8 @@ void swap_init()
 void swap_out(uint8_t *pframe, uint32_t swap_index, struct thread *t)
 {
     ASSERT(swap.sw_table[swap_index] == -1);
+    perf_inc(PERF_SWAP_OUT);
+    trace(TRACE_SWAP_OUT, swap_index, t->tid);
     /* Update the swap table */
     // lock_acquire(&swap.lock);
     swap.sw_table[swap_index] = t;
@@ -62,6 +67,7 @@ void swap_in(uint32_t swap_index, uint8_t *pframe)
     struct thread *t = swap.sw_table[swap_index];
     // DBG_MSG_VM("[VM: %s] Swap instance %d: %s\n", thread_name(), swap_index, t->name);
     ASSERT(thread_current() == swap.sw_table[swap_index]);
+    trace(TRACE_SWAP_IN, swap_index, (uint32_t) ptov(pframe));
     /* Read the target frame to sector */
     int read = 0, sector = swap_index * PGSIZE / BLOCK_SECTOR_SIZE;
     while(read < PGSIZE){
@@ -95,20 +101,31 @@ int swap_alloc()
         return -1;
     }
 }
-/* Swap free, use when free resouce when a process is teardown */
+/* 
+    Swap free, use when free resouce when a process is teardown.
+    Every slot t owns has an entry in its supp table (vaddr without
+    the mmap bit, aux = slot << PGBITS), so only t's own pages are
+    visited. Caller holds frame.lock and swap.lock, which keeps
+    eviction from adding entries meanwhile
+*/
 void swap_free(struct thread *t) 
 {
-    int i, swap_pages = block_size(swap.block_sw) * BLOCK_SECTOR_SIZE / PGSIZE;
-    // lock_acquire(&swap.lock);
-    for( i = 0; i < swap_pages; i++)
+    struct hash_iterator i;
+    if(swap.block_sw == NULL || t->page_mgm == NULL)
+        return;
+    lock_acquire(&t->page_mgm->lock);
+    hash_first(&i, t->page_mgm->page_table);
+    while(hash_next(&i))
     {
-        if(swap.sw_table[i] == t)
-        {
-            // DBG_MSG_VM("[VM: %s] free swap %d\n", t->name, i);
-            swap.sw_table[i] = NULL;
-        }
+        struct page *p = hash_entry(hash_cur(&i), struct page, hash_elem);
+        if(((uint32_t) p->vaddr & PTE_AVL) || p->aux == -1)
+            continue; /* mmap or not yet loaded page */
+        uint32_t swap_index = (uint32_t) p->aux >> PGBITS;
+        ASSERT(swap.sw_table[swap_index] == t);
+        // DBG_MSG_VM("[VM: %s] free swap %d\n", t->name, swap_index);
+        swap.sw_table[swap_index] = NULL;
     }
-    // lock_release(&swap.lock);
+    lock_release(&t->page_mgm->lock);
 }
 
 static void dump_swap_table()